@@ -23,6 +23,8 @@ set_property(TEST t_webget PROPERTY FIXTURES_REQUIRED compile)
 # ttest(byte_stream_two_writes)
 # ttest(byte_stream_many_writes)
 # ttest(byte_stream_stress_test)
+ttest(byte_stream_zero_copy)
+ttest(byte_stream_peek_iov)
 
 # ttest(reassembler_single)
 # ttest(reassembler_cap)
@@ -31,6 +33,8 @@ set_property(TEST t_webget PROPERTY FIXTURES_REQUIRED compile)
 # ttest(reassembler_holes)
 # ttest(reassembler_overlapping)
 # ttest(reassembler_win)
+ttest(reassembler_fast_path)
+ttest(reassembler_budget)
 
 # ttest(wrapping_integers_cmp)
 # ttest(wrapping_integers_wrap)
@@ -45,6 +49,10 @@ set_property(TEST t_webget PROPERTY FIXTURES_REQUIRED compile)
 # ttest(recv_reorder_more)
 # ttest(recv_close)
 # ttest(recv_special)
+ttest(recv_sack)
+ttest(recv_window_scale)
+ttest(recv_delayed_ack)
+ttest(recv_autotune)
 
 # ttest(send_connect)
 # ttest(send_transmit)
@@ -53,8 +61,21 @@ set_property(TEST t_webget PROPERTY FIXTURES_REQUIRED compile)
 # ttest(send_ack)
 # ttest(send_close)
 # ttest(send_extra)
+ttest(send_sack)
+ttest(send_rtt)
+ttest(send_congestion)
+ttest(send_fast_retx)
+ttest(send_pacing)
+ttest(send_nagle)
+ttest(send_mss)
+ttest(send_window_scale)
+ttest(timer_wheel)
+
+ttest(tcp_segment)
+ttest(tcp_peer)
 
 ttest(net_interface)
+ttest(network_simulator)
 
 add_custom_target (check0 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R 'webget|^byte_stream_')
 
@@ -85,4 +106,10 @@ set_property(TEST ${compile_name_opt} PROPERTY TIMEOUT -1)
 set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
-stest(reassembler_speed_test)
\ No newline at end of file
+stest(reassembler_speed_test)
+stest(sender_speed_test)
+stest(receiver_window_speed_test)
+stest(timer_wheel_speed_test)
+stest(net_interface_speed_test)
+stest(loopback_speed_test)
+stest(network_simulator_speed_test)
\ No newline at end of file
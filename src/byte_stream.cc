@@ -1,10 +1,11 @@
+#include <algorithm>
 #include <stdexcept>
 
 #include "byte_stream.hh"
 
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
+ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ), buffer_( capacity, '\0' ) {}
 
 void Writer::push( const string& data )
 {
@@ -12,13 +13,56 @@ void Writer::push( const string& data )
     return;
   }
 
-  if ( data.length() > available_capacity() ) {
-    queue_.append( data.substr( 0, available_capacity() ) );
-    tot_len_ += available_capacity();
-  } else {
-    queue_.append( data );
-    tot_len_ += data.length();
+  const uint64_t len = min( static_cast<uint64_t>( data.length() ), available_capacity() );
+  if ( len == 0 ) {
+    return;
+  }
+
+  // copy into the free region, which may wrap around the end of the storage; behind any adopted chunks, the
+  // bytes are counted against the last one so that they are read after it
+  const uint64_t tail = ( head_ + ring_used_ ) % capacity_;
+  const uint64_t first_part = min( len, capacity_ - tail );
+  data.copy( buffer_.data() + tail, first_part );
+  data.copy( buffer_.data(), len - first_part, first_part );
+  ring_used_ += len;
+  ( chunks_.empty() ? ring_len_ : ring_behind_.back() ) += len;
+  tot_len_ += len;
+  bytes_copied_ += len;
+}
+
+void Writer::push( string&& data )
+{
+  if ( is_closed() || error_ || data.empty() ) {
+    return;
+  }
+
+  const uint64_t len = min( static_cast<uint64_t>( data.length() ), available_capacity() );
+  if ( len == 0 ) {
+    return;
+  }
+
+  data.resize( len ); // shrinking never reallocates
+  chunks_.push_back( std::move( data ) );
+  ring_behind_.push_back( 0 );
+  tot_len_ += len;
+  bytes_adopted_ += len;
+}
+
+void Writer::set_capacity( uint64_t capacity )
+{
+  capacity = max( capacity, tot_len_ - out_len_ );
+  if ( capacity == capacity_ ) {
+    return;
   }
+
+  // move the ring bytes to the start of fresh storage, which also releases the old one when shrinking
+  string buffer( capacity, '\0' );
+  const uint64_t first_part = min( ring_used_, capacity_ - head_ );
+  buffer_.copy( buffer.data(), first_part, head_ );
+  buffer_.copy( buffer.data() + first_part, ring_used_ - first_part, 0 );
+  buffer_ = std::move( buffer );
+  head_ = 0;
+  capacity_ = capacity;
 }
 
 void Writer::close()
@@ -36,6 +80,11 @@ bool Writer::is_closed() const
   return this->closed_;
 }
 
+uint64_t Writer::capacity() const
+{
+  return capacity_;
+}
+
 uint64_t Writer::available_capacity() const
 {
   return capacity_ - tot_len_ + out_len_;
@@ -46,15 +95,77 @@ uint64_t Writer::bytes_pushed() const
   return tot_len_;
 }
 
+uint64_t Writer::bytes_copied() const
+{
+  return bytes_copied_;
+}
+
+uint64_t Writer::bytes_adopted() const
+{
+  return bytes_adopted_;
+}
+
 string_view Reader::peek() const
 {
-  return std::string_view( queue_ );
+  // the ring bytes up to the wrap point, or else the remainder of the oldest adopted chunk
+  if ( ring_len_ > 0 ) {
+    return { buffer_.data() + head_, min( ring_len_, capacity_ - head_ ) };
+  }
+  if ( !chunks_.empty() ) {
+    return string_view( front_chunk() ).substr( chunk_offset_ );
+  }
+  return {};
+}
+
+size_t Reader::peek_iov( span<string_view> regions ) const
+{
+  size_t filled = 0;
+  uint64_t pos = head_; // of the next ring bytes in stream order
+  const auto add_ring_run = [&]( uint64_t len ) {
+    if ( len == 0 ) {
+      return;
+    }
+    const uint64_t first_part = min( len, capacity_ - pos );
+    if ( filled < regions.size() ) {
+      regions[filled++] = { buffer_.data() + pos, first_part };
+    }
+    if ( first_part < len && filled < regions.size() ) { // the run wraps around
+      regions[filled++] = { buffer_.data(), len - first_part };
+    }
+    pos = ( pos + len ) % capacity_;
+  };
+
+  add_ring_run( ring_len_ );
+  for ( size_t i = 0; i < chunks_.size() && filled < regions.size(); ++i ) {
+    regions[filled++] = i == 0 ? string_view( front_chunk() ).substr( chunk_offset_ ) : chunks_[i];
+    add_ring_run( ring_behind_[i] );
+  }
+  return filled;
+}
+
+size_t Reader::buffered_regions() const
+{
+  uint64_t pos = head_;
+  const auto ring_regions = [&]( uint64_t len ) -> size_t {
+    if ( len == 0 ) {
+      return 0;
+    }
+    const bool wraps = len > capacity_ - pos;
+    pos = ( pos + len ) % capacity_;
+    return wraps ? 2 : 1;
+  };
+
+  size_t regions = ring_regions( ring_len_ );
+  for ( const uint64_t behind : ring_behind_ ) {
+    regions += 1 + ring_regions( behind );
+  }
+  return regions;
 }
 
 bool Reader::is_finished() const
 {
   // Your code here.
-  return { closed_ && queue_.empty() };
+  return { closed_ && bytes_buffered() == 0 };
 }
 
 bool Reader::has_error() const
@@ -66,12 +177,55 @@ bool Reader::has_error() const
 void Reader::pop( uint64_t len )
 {
   // Your code here.
-  if ( error_ || queue_.empty() ) {
+  len = min( len, bytes_buffered() );
+  if ( error_ || len == 0 ) {
     return;
   }
-
-  queue_ = queue_.substr( len, queue_.length() );
   out_len_ += len;
+
+  while ( len > 0 ) {
+    const uint64_t from_ring = min( len, ring_len_ );
+    ring_len_ -= from_ring;
+    ring_used_ -= from_ring;
+    head_ = ring_used_ == 0 ? 0 : ( head_ + from_ring ) % capacity_;
+    len -= from_ring;
+    if ( len == 0 ) {
+      return;
+    }
+
+    const uint64_t remaining = front_chunk().size() - chunk_offset_;
+    if ( len < remaining ) {
+      chunk_offset_ += len;
+      return;
+    }
+    len -= remaining;
+    ring_len_ = ring_behind_.front(); // the ring bytes behind the chunk are next
+    chunks_.pop_front();
+    ring_behind_.pop_front();
+    shared_chunk_.reset();
+    chunk_offset_ = 0;
+  }
+}
+
+Buffer Reader::pop_buffer( uint64_t len )
+{
+  len = min( len, bytes_buffered() );
+  if ( error_ || len == 0 ) {
+    return {};
+  }
+
+  if ( ring_len_ == 0 && front_chunk().size() - chunk_offset_ >= len ) { // a slice of the oldest chunk
+    if ( !shared_chunk_ ) {
+      shared_chunk_ = make_shared<string>( std::move( chunks_.front() ) );
+    }
+    Buffer slice { shared_chunk_, chunk_offset_, len };
+    pop( len );
+    return slice;
+  }
+
+  string copy;
+  read( *this, len, copy );
+  return copy;
 }
 
 uint64_t Reader::bytes_buffered() const
@@ -84,4 +238,4 @@ uint64_t Reader::bytes_popped() const
 {
   // Your code here.
   return out_len_;
-}
\ No newline at end of file
+}
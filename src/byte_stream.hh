@@ -1,24 +1,42 @@
 #pragma once
 
+#include "buffer.hh"
+
+#include <deque>
+#include <memory>
 #include <queue>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 
 class Reader;
 class Writer;
+class FileDescriptor;
 
 class ByteStream
 {
 protected:
   uint64_t capacity_;
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
-  std::string queue_ {};
+  std::string buffer_;                  // fixed-size circular storage, allocated once in the constructor
+  uint64_t head_ { 0 };                 // offset of the first buffered byte inside `buffer_`
+  uint64_t ring_used_ { 0 };            // bytes buffered in `buffer_`, in stream order from `head_`
+  uint64_t ring_len_ { 0 };             // how many of them precede the adopted chunks
+  std::deque<std::string> chunks_ {};   // caller strings adopted by the rvalue push()
+  std::deque<uint64_t> ring_behind_ {}; // ring bytes copied in after each chunk, before the next one
+  uint64_t chunk_offset_ { 0 };         // bytes already popped from `chunks_.front()`
+  // where chunks_.front() lives once pop_buffer() has handed out a slice of it (its entry is left empty)
+  std::shared_ptr<std::string> shared_chunk_ {};
+  uint64_t bytes_copied_ { 0 };
+  uint64_t bytes_adopted_ { 0 };
   bool closed_ { false };
   bool error_ { false };
   uint64_t tot_len_ { 0 };
   uint64_t out_len_ { 0 };
 
+  const std::string& front_chunk() const { return shared_chunk_ ? *shared_chunk_ : chunks_.front(); }
+
 public:
   explicit ByteStream( uint64_t capacity );
 
@@ -33,21 +51,37 @@ class Writer : public ByteStream
 {
 public:
   void push( const std::string& data ); // Push data to stream, but only as much as available capacity allows.
+  void push( std::string&& data );      // Same, but take ownership of `data` instead of copying it.
+
+  // Change the capacity (but never below the bytes buffered); the storage is reallocated to match
+  void set_capacity( uint64_t capacity );
 
   void close();     // Signal that the stream has reached its ending. Nothing more will be written.
   void set_error(); // Signal that the stream suffered an error.
 
   bool is_closed() const;              // Has the stream been closed?
+  uint64_t capacity() const;           // How many bytes can the stream hold at most?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+  uint64_t bytes_copied() const;  // Bytes pushed by copying into the stream's own storage
+  uint64_t bytes_adopted() const; // Bytes pushed by adopting the caller's string (zero-copy)
 };
 
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next bytes in the buffer
+  std::string_view peek() const; // Peek at the next bytes in the buffer (the largest contiguous run)
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Remove up to `len` bytes and hand them over as a Buffer. When they lie within one adopted chunk, the Buffer
+  // shares it instead of copying them; otherwise they are copied once, into the Buffer's own storage.
+  Buffer pop_buffer( uint64_t len );
+
+  // Fill `regions` with views of the buffered bytes, in order; returns how many were filled
+  size_t peek_iov( std::span<std::string_view> regions ) const;
+  size_t buffered_regions() const; // How many views would peek_iov() need to cover every buffered byte?
+
   bool is_finished() const; // Is the stream finished (closed and fully popped)?
   bool has_error() const;   // Has the stream had an error?
 
@@ -60,3 +94,9 @@ public:
  * from a ByteStream Reader into a string;
  */
 void read( Reader& reader, uint64_t len, std::string& out );
+
+/*
+ * write: A helper function that writes as much of a ByteStream Reader as `fd` accepts
+ * with a single writev, then pops what was written. Returns the number of bytes written.
+ */
+uint64_t write( Reader& reader, FileDescriptor& fd );
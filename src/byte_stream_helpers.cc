@@ -1,7 +1,12 @@
 #include "byte_stream.hh"
+#include "file_descriptor.hh"
 
+#include <algorithm>
+#include <array>
+#include <climits>
 #include <cstdint>
 #include <stdexcept>
+#include <vector>
 
 /*
  * read: A helper function thats peeks and pops up to `len` bytes
@@ -10,20 +15,42 @@
 void read( Reader& reader, uint64_t len, std::string& out )
 {
   out.clear();
+  out.reserve( std::min( len, reader.bytes_buffered() ) );
 
+  std::array<std::string_view, 8> views;
   while ( reader.bytes_buffered() and out.size() < len ) {
-    auto view = reader.peek();
+    const size_t filled = reader.peek_iov( views );
+    const size_t prev_size = out.size();
 
-    if ( view.empty() ) {
-      throw std::runtime_error( "Reader::peek() returned empty string_view" );
+    for ( size_t i = 0; i < filled and out.size() < len; i++ ) {
+      out += views.at( i ).substr( 0, len - out.size() ); // Don't return more bytes than desired.
     }
 
-    view = view.substr( 0, len - out.size() ); // Don't return more bytes than desired.
-    out += view;
-    reader.pop( view.size() );
+    if ( out.size() == prev_size ) {
+      throw std::runtime_error( "Reader::peek_iov() returned no bytes" );
+    }
+    reader.pop( out.size() - prev_size );
   }
 }
 
+/*
+ * write: A helper function that writes as much of a ByteStream Reader as `fd` accepts
+ * with a single writev, then pops what was written.
+ */
+uint64_t write( Reader& reader, FileDescriptor& fd )
+{
+  if ( reader.bytes_buffered() == 0 ) {
+    return 0;
+  }
+
+  std::vector<std::string_view> views( std::min<size_t>( reader.buffered_regions(), IOV_MAX ) );
+  views.resize( reader.peek_iov( views ) );
+
+  const uint64_t written = fd.write( views );
+  reader.pop( written );
+  return written;
+}
+
 Reader& ByteStream::reader()
 {
   static_assert( sizeof( Reader ) == sizeof( ByteStream ),
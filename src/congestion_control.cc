@@ -0,0 +1,121 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+NewReno::NewReno( uint64_t mss, uint64_t initial_window )
+  : mss_( mss ), cwnd_( initial_window ? initial_window : min( 4 * mss, max( 2 * mss, uint64_t { 4380 } ) ) )
+{}
+
+void NewReno::on_ack( uint64_t acked, uint64_t now_ms, optional<uint64_t> srtt_ms )
+{
+  if ( cwnd_ < ssthresh_ ) { // slow start: one MSS per ack at most, so stretch acks can't burst
+    cwnd_ += min( acked, mss_ );
+    return;
+  }
+  congestion_avoidance( acked, now_ms, srtt_ms );
+}
+
+void NewReno::congestion_avoidance( uint64_t acked, uint64_t /* now_ms */, optional<uint64_t> /* srtt_ms */ )
+{
+  // appropriate byte counting: one MSS for every cwnd's worth of acked data, i.e. per RTT
+  bytes_acked_ += acked;
+  if ( bytes_acked_ >= cwnd_ ) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+uint64_t NewReno::loss_threshold( uint64_t bytes_in_flight, uint64_t /* now_ms */ )
+{
+  return max( bytes_in_flight / 2, 2 * mss_ );
+}
+
+void NewReno::on_enter_recovery( uint64_t bytes_in_flight, uint64_t now_ms )
+{
+  ssthresh_ = loss_threshold( bytes_in_flight, now_ms );
+  cwnd_ = ssthresh_ + 3 * mss_; // the three duplicate acks stand for segments that have left the network
+  bytes_acked_ = 0;
+}
+
+void NewReno::on_duplicate_ack()
+{
+  cwnd_ += mss_;
+}
+
+void NewReno::on_partial_ack( uint64_t acked )
+{
+  // RFC 6582, section 3.2: deflate by the amount acked, then add back one MSS if at least that much was acked
+  cwnd_ -= min( acked, cwnd_ );
+  if ( acked >= mss_ ) {
+    cwnd_ += mss_;
+  }
+  cwnd_ = max( cwnd_, mss_ );
+}
+
+void NewReno::on_exit_recovery()
+{
+  cwnd_ = ssthresh_;
+}
+
+void NewReno::on_timeout( uint64_t bytes_in_flight, uint64_t now_ms )
+{
+  ssthresh_ = loss_threshold( bytes_in_flight, now_ms );
+  cwnd_ = mss_; // the loss window
+  bytes_acked_ = 0;
+}
+
+void Cubic::congestion_avoidance( uint64_t acked, uint64_t now_ms, optional<uint64_t> srtt_ms )
+{
+  /**
+   * RFC 9438, section 4: cwnd follows W_cubic(t) = C * (t - K)^3 + W_max, where t is the time since the epoch
+   * began, and is never smaller than what Reno would have reached (W_est). Each ack closes the gap to the
+   * value one RTT ahead by 1/cwnd of it, capped at 1.5 * cwnd.
+   */
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  if ( !epoch_start_ms_.has_value() ) {
+    epoch_start_ms_ = now_ms;
+    if ( cwnd < w_max_ ) {
+      k_ = cbrt( ( w_max_ - cwnd ) / C );
+    } else {
+      k_ = 0;
+      w_max_ = cwnd;
+    }
+    w_est_ = cwnd;
+  }
+
+  const double segments_acked = static_cast<double>( acked ) / static_cast<double>( mss_ );
+  w_est_ += 3 * ( 1 - BETA ) / ( 1 + BETA ) * segments_acked / cwnd;
+
+  const double t = static_cast<double>( now_ms - *epoch_start_ms_ + srtt_ms.value_or( 0 ) ) / 1000;
+  const double w_cubic = C * pow( t - k_, 3 ) + w_max_;
+  const double target = max( w_est_, clamp( w_cubic, cwnd, 1.5 * cwnd ) );
+
+  growth_ += ( target - cwnd ) / cwnd * static_cast<double>( acked );
+  const auto whole = static_cast<uint64_t>( growth_ );
+  cwnd_ += whole;
+  growth_ -= static_cast<double>( whole );
+}
+
+uint64_t Cubic::loss_threshold( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ )
+{
+  // fast convergence: if the window didn't get back to the last W_max, release some bandwidth to newer flows
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  w_max_ = cwnd < w_max_ ? cwnd * ( 1 + BETA ) / 2 : cwnd;
+  epoch_start_ms_.reset();
+  growth_ = 0;
+  return max( static_cast<uint64_t>( static_cast<double>( cwnd_ ) * BETA ), 2 * mss_ );
+}
+
+unique_ptr<CongestionControl> make_congestion_control( string_view name, uint64_t mss )
+{
+  if ( name == "newreno" ) {
+    return make_unique<NewReno>( mss );
+  }
+  if ( name == "cubic" ) {
+    return make_unique<Cubic>( mss );
+  }
+  return nullptr;
+}
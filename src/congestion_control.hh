@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+/*
+ * A congestion controller decides how many sequence numbers the TCPSender may have in flight (cwnd). The
+ * sender reports acks, losses and timeouts; it never changes the window itself. All sizes are in sequence
+ * numbers, all times in milliseconds of the sender's clock.
+ */
+class CongestionControl
+{
+public:
+  virtual ~CongestionControl() = default;
+
+  virtual std::string_view name() const = 0;
+  virtual uint64_t window() const = 0;   // cwnd
+  virtual uint64_t ssthresh() const = 0; // slow start threshold
+
+  /* `acked` new payload bytes were acknowledged outside of loss recovery */
+  virtual void on_ack( uint64_t acked, uint64_t now_ms, std::optional<uint64_t> srtt_ms ) = 0;
+
+  /* A third duplicate ack: the sender fast-retransmits and enters fast recovery */
+  virtual void on_enter_recovery( uint64_t bytes_in_flight, uint64_t now_ms ) = 0;
+
+  /* Another duplicate ack during fast recovery: a segment has left the network */
+  virtual void on_duplicate_ack() = 0;
+
+  /* An ack during fast recovery that acknowledges `acked` new payload bytes but not everything outstanding */
+  virtual void on_partial_ack( uint64_t acked ) = 0;
+
+  /* Everything outstanding at the start of fast recovery has been acknowledged */
+  virtual void on_exit_recovery() = 0;
+
+  /* The retransmission timer expired */
+  virtual void on_timeout( uint64_t bytes_in_flight, uint64_t now_ms ) = 0;
+};
+
+/* Slow start, congestion avoidance and fast recovery from RFC 5681 with the NewReno changes of RFC 6582 */
+class NewReno : public CongestionControl
+{
+public:
+  /* An `initial_window` of 0 picks the RFC 5681 one: min(4 * mss, max(2 * mss, 4380)) */
+  explicit NewReno( uint64_t mss, uint64_t initial_window = 0 );
+
+  std::string_view name() const override { return "NewReno"; }
+  uint64_t window() const override { return cwnd_; }
+  uint64_t ssthresh() const override { return ssthresh_; }
+
+  void on_ack( uint64_t acked, uint64_t now_ms, std::optional<uint64_t> srtt_ms ) override;
+  void on_enter_recovery( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+  void on_duplicate_ack() override;
+  void on_partial_ack( uint64_t acked ) override;
+  void on_exit_recovery() override;
+  void on_timeout( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+
+protected:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ = UINT64_MAX;
+
+  /* Grow cwnd once it has reached ssthresh */
+  virtual void congestion_avoidance( uint64_t acked, uint64_t now_ms, std::optional<uint64_t> srtt_ms );
+
+  /* The ssthresh to use after a loss */
+  virtual uint64_t loss_threshold( uint64_t bytes_in_flight, uint64_t now_ms );
+
+private:
+  uint64_t bytes_acked_ = 0; // acked since cwnd last grew in congestion avoidance (RFC 3465)
+};
+
+/* CUBIC window growth (RFC 9438), with NewReno's slow start and recovery */
+class Cubic : public NewReno
+{
+public:
+  static constexpr double C = 0.4;    // scaling constant, in segments per second cubed
+  static constexpr double BETA = 0.7; // multiplicative decrease factor
+
+  using NewReno::NewReno;
+
+  std::string_view name() const override { return "CUBIC"; }
+
+protected:
+  void congestion_avoidance( uint64_t acked, uint64_t now_ms, std::optional<uint64_t> srtt_ms ) override;
+  uint64_t loss_threshold( uint64_t bytes_in_flight, uint64_t now_ms ) override;
+
+private:
+  std::optional<uint64_t> epoch_start_ms_ {}; // when the current congestion avoidance epoch began
+  double w_max_ = 0;                          // cwnd just before the last reduction, in segments
+  double k_ = 0;                              // seconds the cubic takes to climb back to w_max_
+  double w_est_ = 0;                          // what Reno would have reached in this epoch, in segments
+  double growth_ = 0;                         // fraction of a sequence number not yet added to cwnd
+};
+
+/* Make a controller by name ("newreno" or "cubic"), or nullptr if there is no such one */
+std::unique_ptr<CongestionControl> make_congestion_control( std::string_view name, uint64_t mss );
@@ -3,15 +3,44 @@
 #include "arp_message.hh"
 #include "ethernet_frame.hh"
 
+#include <stdexcept>
+
 using namespace std;
 
+// bytes a datagram occupies while it waits
+static size_t datagram_size( const InternetDatagram& dgram )
+{
+  size_t size = static_cast<size_t>( dgram.header.hlen ) * 4;
+  for ( const auto& buffer : dgram.payload ) {
+    size += buffer.size();
+  }
+  return size;
+}
+
 // ethernet_address: Ethernet (what ARP calls "hardware") address of the interface
 // ip_address: IP (what ARP calls "protocol") address of the interface
-NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address )
-  : ethernet_address_( ethernet_address ), ip_address_( ip_address )
+// mtu: largest datagram the link carries in one frame
+NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address, size_t mtu )
+  : NetworkInterface( ethernet_address, ip_address, mtu, true )
+{}
+
+NetworkInterface NetworkInterface::quiet( const EthernetAddress& ethernet_address,
+                                          const Address& ip_address,
+                                          size_t mtu )
 {
-  cerr << "DEBUG: Network interface has Ethernet address " << to_string( ethernet_address_ ) << " and IP address "
-       << ip_address.ip() << "\n";
+  return { ethernet_address, ip_address, mtu, false };
+}
+
+NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address,
+                                    const Address& ip_address,
+                                    size_t mtu,
+                                    bool announce )
+  : ethernet_address_( ethernet_address ), ip_address_( ip_address ), mtu_( mtu )
+{
+  if ( announce ) {
+    cerr << "DEBUG: Network interface has Ethernet address " << to_string( ethernet_address_ )
+         << " and IP address " << ip_address.ip() << "\n";
+  }
 }
 
 // dgram: the IPv4 datagram to be sent
@@ -23,36 +52,70 @@ NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, con
 void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Address& next_hop )
 {
   const uint32_t next_hop_ip = next_hop.ipv4_numeric();
-  if ( arp_table_.contains( next_hop_ip ) ) { // contains the ethernet address
-    EthernetFrame frame;
-    frame.payload = serialize( dgram );
-    frame.header.dst = arp_table_[next_hop_ip].eth_addr;
-    frame.header.src = this->ethernet_address_;
-    frame.header.type = EthernetHeader::TYPE_IPv4;
-    outbound_frames_.push( frame );
+  if ( const auto entry = arp_table_.find( next_hop_ip ); entry != arp_table_.end() ) { // knows the ethernet
+    transmit( dgram, entry->second.eth_addr );
   } else { // broadcast ARP request
     // if we didnt send the request
-    if ( arp_requests_lifetime_.find( next_hop_ip ) == arp_requests_lifetime_.end() ) {
-      ARPMessage arp_msg;
-      arp_msg.opcode = ARPMessage::OPCODE_REQUEST;
-      arp_msg.sender_ip_address = ip_address_.ipv4_numeric();
-      arp_msg.sender_ethernet_address = ethernet_address_;
-      arp_msg.target_ip_address = next_hop_ip;
-      arp_msg.target_ethernet_address = { /* empty */ };
-
-      EthernetFrame arp_eth_frame;
-      arp_eth_frame.header.src = ethernet_address_;
-      arp_eth_frame.header.dst = ETHERNET_BROADCAST;
-      arp_eth_frame.header.type = EthernetHeader::TYPE_ARP;
-      arp_eth_frame.payload = serialize( arp_msg );
-      outbound_frames_.push( arp_eth_frame );
-
-      arp_requests_lifetime_.insert( std::make_pair( next_hop_ip, ARP_REQUEST_DEFAULT_TTL ) );
+    if ( !arp_request_timers_.contains( next_hop_ip ) ) {
+      request_arp( next_hop_ip );
     }
 
-    // if we already send that request
-    arp_datagrams_waiting_list_.push_back( std::pair { next_hop, dgram } );
+    // wait for the reply with the others for the same next hop
+    enqueue( dgram, next_hop_ip );
+  }
+}
+
+void NetworkInterface::enqueue( const InternetDatagram& dgram, const uint32_t next_hop_ip )
+{
+  const size_t bytes = datagram_size( dgram );
+  auto queue = pending_datagrams_.find( next_hop_ip );
+  const size_t depth = queue == pending_datagrams_.end() ? 0 : queue->second.datagrams.size();
+  if ( depth >= max_pending_per_hop_ || pending_bytes_ + bytes > max_pending_bytes_ ) {
+    ++datagrams_dropped_;
+    return;
+  }
+
+  if ( queue == pending_datagrams_.end() ) {
+    const auto expire = on_timer( [next_hop_ip]( NetworkInterface& self ) { self.expire_pending( next_hop_ip ); } );
+    const auto expiry = timers().schedule( ARP_REQUEST_DEFAULT_TTL, expire );
+    queue = pending_datagrams_.emplace( next_hop_ip, PendingQueue { {}, expiry } ).first;
+  }
+  queue->second.datagrams.push( { dgram, timers().now() + ARP_REQUEST_DEFAULT_TTL, bytes } );
+  pending_bytes_ += bytes;
+  ++datagrams_queued_;
+}
+
+void NetworkInterface::expire_pending( const uint32_t next_hop_ip )
+{
+  const auto queue = pending_datagrams_.find( next_hop_ip );
+  if ( queue == pending_datagrams_.end() ) {
+    return;
+  }
+
+  auto& datagrams = queue->second.datagrams;
+  while ( !datagrams.empty() && datagrams.front().deadline <= timers().now() ) {
+    pending_bytes_ -= datagrams.front().bytes;
+    ++datagrams_dropped_;
+    datagrams.pop();
+  }
+
+  timers().cancel( queue->second.expiry );
+  if ( datagrams.empty() ) {
+    pending_datagrams_.erase( queue );
+    return;
   }
+  const auto expire = on_timer( [next_hop_ip]( NetworkInterface& self ) { self.expire_pending( next_hop_ip ); } );
+  queue->second.expiry = timers().schedule( datagrams.front().deadline - timers().now(), expire );
+}
+
+void NetworkInterface::transmit( const InternetDatagram& dgram, const EthernetAddress& dst )
+{
+  EthernetFrame frame;
+  frame.payload = serialize( dgram );
+  frame.header.dst = dst;
+  frame.header.src = this->ethernet_address_;
+  frame.header.type = EthernetHeader::TYPE_IPv4;
+  outbound_frames_.push( std::move( frame ) );
 }
 
 // frame: the incoming Ethernet frame
@@ -104,19 +167,27 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
 
     // we can get arp info from either ARP request or ARP reply
     if ( is_arp_request || is_arp_response ) {
-      arp_table_.emplace(
-        std::make_pair( arp_msg.sender_ip_address, arp_t { arp_msg.sender_ethernet_address, ARP_DEFAULT_TTL } ) );
-      // delete arp datagrams waiting list
-      for ( auto iter = arp_datagrams_waiting_list_.begin(); iter != arp_datagrams_waiting_list_.end(); ) {
-        const auto& [ipv4_addr, datagram] = *iter;
-        if ( ipv4_addr.ipv4_numeric() == arp_msg.sender_ip_address ) {
-          send_datagram( datagram, ipv4_addr );
-          iter = arp_datagrams_waiting_list_.erase( iter );
-        } else {
-          iter++;
+      const uint32_t sender_ip = arp_msg.sender_ip_address;
+      if ( !arp_table_.contains( sender_ip ) ) {
+        const auto forget
+          = on_timer( [sender_ip]( NetworkInterface& self ) { self.arp_table_.erase( sender_ip ); } );
+        const auto expiry = timers().schedule( ARP_DEFAULT_TTL, forget );
+        arp_table_.emplace( sender_ip, arp_t { arp_msg.sender_ethernet_address, expiry } );
+      }
+      // send the datagrams that were waiting for this address
+      if ( const auto pending = pending_datagrams_.find( sender_ip ); pending != pending_datagrams_.end() ) {
+        timers().cancel( pending->second.expiry );
+        for ( auto& datagrams = pending->second.datagrams; !datagrams.empty(); datagrams.pop() ) {
+          transmit( datagrams.front().dgram, arp_msg.sender_ethernet_address );
+          pending_bytes_ -= datagrams.front().bytes;
+          ++datagrams_flushed_;
         }
+        pending_datagrams_.erase( pending );
+      }
+      if ( const auto request = arp_request_timers_.find( sender_ip ); request != arp_request_timers_.end() ) {
+        timers().cancel( request->second );
+        arp_request_timers_.erase( request );
       }
-      arp_requests_lifetime_.erase( arp_msg.sender_ip_address );
     }
   }
   return nullopt;
@@ -125,42 +196,62 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
 // ms_since_last_tick: the number of milliseconds since the last call to this method
 void NetworkInterface::tick( const size_t ms_since_last_tick )
 {
-  /* delete expired ARP items in ARP Table */
-  // FIXME: Don't use 'iter++' if we have erase current iter's data!
-  for ( auto iter = arp_table_.begin(); iter != arp_table_.end(); /* nop */ ) {
-    auto& [ipv4_addr_numeric, arp] = *iter;
-    if ( arp.ttl <= ms_since_last_tick ) {
-      iter = arp_table_.erase( iter );
-    } else {
-      arp.ttl -= ms_since_last_tick;
-      iter++;
-    }
+  // expired ARP items leave the ARP table, and expired ARP requests are sent again, as their timers fire
+  if ( !timers_ || own_timers_ ) { // a shared wheel is advanced by its owner
+    timers().advance( ms_since_last_tick );
+  }
+}
+
+TimerWheel& NetworkInterface::timers()
+{
+  if ( !timers_ ) {
+    own_timers_ = make_unique<TimerWheel>();
+    timers_ = own_timers_.get();
   }
+  return *timers_;
+}
 
-  /* delete expired ARP requests */
-  for ( auto& [ipv4_addr, arp_ttl] : arp_requests_lifetime_ ) {
-    /* resent ARP request if this request has expired */
-    if ( arp_ttl <= ms_since_last_tick ) {
-      ARPMessage arp_msg;
-      arp_msg.opcode = ARPMessage::OPCODE_REQUEST;
-      arp_msg.sender_ip_address = ip_address_.ipv4_numeric();
-      arp_msg.sender_ethernet_address = ethernet_address_;
-      arp_msg.target_ip_address = ipv4_addr;
-      arp_msg.target_ethernet_address = { /* empty */ };
-
-      EthernetFrame arp_eth_frame;
-      arp_eth_frame.header.src = ethernet_address_;
-      arp_eth_frame.header.dst = ETHERNET_BROADCAST;
-      arp_eth_frame.header.type = EthernetHeader::TYPE_ARP;
-      arp_eth_frame.payload = serialize( arp_msg );
-      outbound_frames_.push( arp_eth_frame );
-
-      /* reset ARP ttl for this component */
-      arp_ttl = ARP_REQUEST_DEFAULT_TTL;
+void NetworkInterface::use_timer_wheel( TimerWheel& wheel )
+{
+  if ( !arp_table_.empty() || !arp_request_timers_.empty() ) {
+    throw runtime_error( "NetworkInterface: use_timer_wheel() after ARP timers were started" );
+  }
+  timers_ = &wheel;
+  own_timers_.reset();
+}
+
+void NetworkInterface::set_pending_limits( const size_t datagrams_per_hop, const size_t bytes )
+{
+  max_pending_per_hop_ = datagrams_per_hop;
+  max_pending_bytes_ = bytes;
+}
+
+void NetworkInterface::request_arp( const uint32_t ip )
+{
+  ARPMessage arp_msg;
+  arp_msg.opcode = ARPMessage::OPCODE_REQUEST;
+  arp_msg.sender_ip_address = ip_address_.ipv4_numeric();
+  arp_msg.sender_ethernet_address = ethernet_address_;
+  arp_msg.target_ip_address = ip;
+  arp_msg.target_ethernet_address = { /* empty */ };
+
+  EthernetFrame arp_eth_frame;
+  arp_eth_frame.header.src = ethernet_address_;
+  arp_eth_frame.header.dst = ETHERNET_BROADCAST;
+  arp_eth_frame.header.type = EthernetHeader::TYPE_ARP;
+  arp_eth_frame.payload = serialize( arp_msg );
+  outbound_frames_.push( arp_eth_frame );
+
+  // ask again while datagrams are still waiting; otherwise the next datagram will
+  const auto retry = on_timer( [ip]( NetworkInterface& self ) {
+    self.expire_pending( ip );
+    if ( self.pending_datagrams_.contains( ip ) ) {
+      self.request_arp( ip );
     } else {
-      arp_ttl -= ms_since_last_tick;
+      self.arp_request_timers_.erase( ip );
     }
-  }
+  } );
+  arp_request_timers_[ip] = timers().schedule( ARP_REQUEST_DEFAULT_TTL, retry );
 }
 
 optional<EthernetFrame> NetworkInterface::maybe_send()
@@ -3,9 +3,10 @@
 #include "address.hh"
 #include "ethernet_frame.hh"
 #include "ipv4_datagram.hh"
+#include "timer_wheel.hh"
 
 #include <iostream>
-#include <list>
+#include <memory>
 #include <optional>
 #include <queue>
 #include <unordered_map>
@@ -32,7 +33,7 @@
 // the network interface passes it up the stack. If it's an ARP
 // request or reply, the network interface processes the frame
 // and learns or replies as necessary.
-class NetworkInterface
+class NetworkInterface : public TimerOwner<NetworkInterface>
 {
 private:
   // Ethernet (known as hardware, network-access, or link-layer) address of the interface
@@ -41,6 +42,9 @@ private:
   // IP (known as Internet-layer or network-layer) address of the interface
   Address ip_address_;
 
+  // Largest datagram the link carries in one frame
+  size_t mtu_;
+
   // outbound Ethernet frames which will be sent by the Network Interface
   std::queue<EthernetFrame> outbound_frames_ {};
 
@@ -48,19 +52,86 @@ private:
   // increasing the enquiry speed.
   const size_t ARP_DEFAULT_TTL = static_cast<size_t>( 30 * 1000 );
   const size_t ARP_REQUEST_DEFAULT_TTL = static_cast<size_t>( 5 * 1000 );
+
+  // Mappings expire, and unanswered ARP requests are repeated, by timers on the interface's own wheel (which
+  // tick() advances) or a shared one. Their callbacks find the interface through TimerOwner, so it can be moved.
+  // The own wheel is only made on the first tick() or timer.
+  std::unique_ptr<TimerWheel> own_timers_ {};
+  TimerWheel* timers_ {};
+
   using arp_t = struct
   {
-    EthernetAddress eth_addr; // mac address
-    size_t ttl;               // time to live
+    EthernetAddress eth_addr;   // mac address
+    TimerWheel::TimerId expiry; // forgets the mapping
   };
   std::unordered_map<uint32_t /* ipv4 numeric */, arp_t> arp_table_ {};
-  std::unordered_map<uint32_t /* ipv4 numeric */, size_t /* ttl */> arp_requests_lifetime_ {};
-  std::list<std::pair<Address, InternetDatagram>> arp_datagrams_waiting_list_ {};
+  std::unordered_map<uint32_t /* ipv4 numeric */, TimerWheel::TimerId /* resend */> arp_request_timers_ {};
+
+  // Datagrams waiting for the Ethernet address of their next hop, grouped by it: a reply sends just its own.
+  // Each waits at most ARP_REQUEST_DEFAULT_TTL, and a queue's timer drops those that have waited that long.
+  struct PendingDatagram
+  {
+    InternetDatagram dgram;
+    uint64_t deadline; // on the timer wheel's clock
+    size_t bytes;
+  };
+  struct PendingQueue
+  {
+    std::queue<PendingDatagram> datagrams;
+    TimerWheel::TimerId expiry; // fires when the oldest datagram has waited too long
+  };
+  std::unordered_map<uint32_t /* ipv4 numeric */, PendingQueue> pending_datagrams_ {};
+
+  // Bounds on the pending datagrams, and what became of them
+  size_t max_pending_per_hop_ { DEFAULT_PENDING_DATAGRAMS_PER_HOP };
+  size_t max_pending_bytes_ { DEFAULT_PENDING_BYTES };
+  size_t pending_bytes_ { 0 };
+  uint64_t datagrams_queued_ { 0 };
+  uint64_t datagrams_flushed_ { 0 };
+  uint64_t datagrams_dropped_ { 0 };
+
+  // Queue a datagram in an Ethernet frame to a known address
+  void transmit( const InternetDatagram& dgram, const EthernetAddress& dst );
+
+  // Hold a datagram until `next_hop_ip` is resolved, or drop it if that would exceed the bounds
+  void enqueue( const InternetDatagram& dgram, uint32_t next_hop_ip );
+
+  // Drop the datagrams for `next_hop_ip` that have waited too long, and time the next one
+  void expire_pending( uint32_t next_hop_ip );
+
+  // Broadcast an ARP request for `ip`, and again every ARP_REQUEST_DEFAULT_TTL while datagrams wait for it
+  void request_arp( uint32_t ip );
+
+  // The wheel the interface's timers run on, making its own on first use if it was given none
+  TimerWheel& timers();
+
+  NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address, size_t mtu, bool announce );
 
 public:
+  static constexpr size_t DEFAULT_MTU = 1500; // Ethernet
+
+  // Bounds on the datagrams waiting for ARP replies (like Linux's unres_qlen, and a megabyte in all)
+  static constexpr size_t DEFAULT_PENDING_DATAGRAMS_PER_HOP = 100;
+  static constexpr size_t DEFAULT_PENDING_BYTES = 1 << 20;
+
   // Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer)
-  // addresses
-  NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address );
+  // addresses, on a link with the given MTU
+  NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address, size_t mtu = DEFAULT_MTU );
+
+  // The same, without announcing the addresses on stderr (for simulations that build thousands)
+  static NetworkInterface quiet( const EthernetAddress& ethernet_address,
+                                 const Address& ip_address,
+                                 size_t mtu = DEFAULT_MTU );
+
+  // Move-only: the ARP timers belong to one interface, and move with it
+  NetworkInterface( const NetworkInterface& ) = delete;
+  NetworkInterface& operator=( const NetworkInterface& ) = delete;
+  NetworkInterface( NetworkInterface&& ) = default;
+  NetworkInterface& operator=( NetworkInterface&& ) = default;
+  ~NetworkInterface() = default;
+
+  // Largest datagram the link carries in one frame; TCPConfig::mss_for_mtu() turns it into an MSS
+  size_t mtu() const { return mtu_; }
 
   // Access queue of Ethernet frames awaiting transmission
   std::optional<EthernetFrame> maybe_send();
@@ -80,4 +151,17 @@ public:
 
   // Called periodically when time elapses
   void tick( size_t ms_since_last_tick );
+
+  // Hold at most `datagrams_per_hop` datagrams for each next hop that hasn't answered its ARP request, and
+  // `bytes` for all of them. A datagram that doesn't fit is dropped.
+  void set_pending_limits( size_t datagrams_per_hop, size_t bytes );
+
+  uint64_t datagrams_queued() const { return datagrams_queued_; }   // held for an ARP reply
+  uint64_t datagrams_flushed() const { return datagrams_flushed_; } // sent once the reply came
+  uint64_t datagrams_dropped() const { return datagrams_dropped_; } // didn't fit, or waited too long
+  size_t pending_bytes() const { return pending_bytes_; }           // held now
+
+  // Run the ARP timers on a wheel shared with other interfaces (or TCPSenders). Call it before the first
+  // datagram or frame; from then on, advance the wheel instead of calling tick().
+  void use_timer_wheel( TimerWheel& wheel );
 };
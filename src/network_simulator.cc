@@ -0,0 +1,339 @@
+#include "network_simulator.hh"
+
+#include "parser.hh"
+#include "tcp_segment.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static EthernetAddress ethernet_address( uint8_t role, size_t host )
+{
+  return { 0x02, role, static_cast<uint8_t>( host >> 24 ), static_cast<uint8_t>( host >> 16 ),
+           static_cast<uint8_t>( host >> 8 ), static_cast<uint8_t>( host ) };
+}
+
+double NetworkSimulator::LinkStats::mean_queueing_delay_ms() const
+{
+  if ( frames_sent == 0 ) {
+    return 0;
+  }
+  return static_cast<double>( queueing_delay_us ) / 1000 / static_cast<double>( frames_sent );
+}
+
+void NetworkSimulator::Link::send( EthernetFrame frame, uint64_t now_us )
+{
+  uint64_t bytes = EthernetHeader::LENGTH;
+  for ( const auto& buffer : frame.payload ) {
+    bytes += buffer.size();
+  }
+
+  // the bytes still to be serialized when this frame arrives, including what is left of the one on the wire
+  const uint64_t start_us = max( busy_until_us_, now_us );
+  const uint64_t queued_bytes = ( start_us - now_us ) * config_.bits_per_second / 8 / 1000000;
+  if ( queued_bytes + bytes > config_.queue_bytes ) {
+    ++stats_.frames_dropped;
+    return;
+  }
+
+  busy_until_us_ = start_us + ( bytes * 8 * 1000000 + config_.bits_per_second - 1 ) / config_.bits_per_second;
+  ++stats_.frames_sent;
+  stats_.bytes_sent += bytes;
+  stats_.queueing_delay_us += start_us - now_us;
+  stats_.max_queueing_delay_us = max( stats_.max_queueing_delay_us, start_us - now_us );
+  in_flight_.push( { busy_until_us_ + config_.delay_ms * 1000, std::move( frame ) } );
+}
+
+optional<EthernetFrame> NetworkSimulator::Link::receive( uint64_t now_us )
+{
+  if ( in_flight_.empty() || in_flight_.front().arrival_us > now_us ) {
+    return nullopt;
+  }
+  EthernetFrame frame = std::move( in_flight_.front().frame );
+  in_flight_.pop();
+  return frame;
+}
+
+// hosts are 10.0.0.2 and up, and every port of the router is 10.0.0.1
+uint32_t NetworkSimulator::host_ip( size_t host )
+{
+  return 0x0a000002 + static_cast<uint32_t>( host );
+}
+
+uint32_t NetworkSimulator::router_ip()
+{
+  return 0x0a000001;
+}
+
+size_t NetworkSimulator::add_host( const LinkConfig& uplink, const LinkConfig& downlink )
+{
+  const size_t index = hosts_.size();
+  if ( host_ip( index ) < host_ip( 0 ) ) {
+    throw runtime_error( "NetworkSimulator: out of host addresses" );
+  }
+  hosts_.push_back(
+    { NetworkInterface::quiet( ethernet_address( 0, index ), Address::from_ipv4_numeric( host_ip( index ) ) ),
+      NetworkInterface::quiet( ethernet_address( 1, index ), Address::from_ipv4_numeric( router_ip() ) ),
+      Link { uplink },
+      Link { downlink } } );
+  hosts_.back().interface.use_timer_wheel( timers_ );
+  hosts_.back().router_port.use_timer_wheel( timers_ );
+  host_by_ip_.emplace( host_ip( index ), index );
+  return index;
+}
+
+size_t NetworkSimulator::add_flow( size_t from_host, size_t to_host, FlowConfig config )
+{
+  if ( from_host >= hosts_.size() || to_host >= hosts_.size() || from_host == to_host ) {
+    throw runtime_error( "NetworkSimulator: a flow needs two different hosts" );
+  }
+
+  const size_t index = flows_.size();
+  if ( index > UINT16_MAX ) {
+    throw runtime_error( "NetworkSimulator: out of ports" );
+  }
+  const uint64_t capacity = config.capacity;
+  const uint64_t mss = TCPConfig::mss_for_mtu( hosts_[from_host].interface.mtu() );
+  const Wrap32 isn { static_cast<uint32_t>( index * 0x9e3779b9 ) }; // deterministic, but spread out
+  flows_.push_back( { index,
+                      from_host,
+                      to_host,
+                      std::move( config ),
+                      ByteStream { capacity },
+                      TCPSender { TCPConfig::TIMEOUT_DFLT, isn, mss },
+                      ByteStream { capacity },
+                      Reassembler {},
+                      TCPReceiver {},
+                      FlowStats {},
+                      0 } );
+
+  Flow& flow = flows_.back();
+  flow.sender.use_timer_wheel( timers_ );
+  flow.sender.enable_window_scaling();
+  flow.receiver.set_window_scale( TCPConfig::window_scale_for( capacity ) );
+  if ( flow.config.configure ) {
+    flow.config.configure( flow.sender, flow.receiver );
+  }
+  return index;
+}
+
+void NetworkSimulator::tick()
+{
+  const uint64_t now_us = now_ms() * 1000;
+
+  // frames that have crossed a link
+  for ( Host& host : hosts_ ) {
+    while ( auto frame = host.uplink.receive( now_us ) ) {
+      if ( auto dgram = host.router_port.recv_frame( *frame ) ) {
+        route( std::move( *dgram ) );
+      }
+    }
+    while ( auto frame = host.downlink.receive( now_us ) ) {
+      if ( auto dgram = host.interface.recv_frame( *frame ) ) {
+        receive( *dgram );
+      }
+    }
+  }
+
+  // the applications write, and the flows send what they can and acknowledge what is due
+  for ( Flow& flow : flows_ ) {
+    if ( now_ms() < flow.config.start_ms ) {
+      continue;
+    }
+    write( flow );
+    flow.sender.push( flow.outbound.reader() );
+    while ( auto msg = flow.sender.maybe_send() ) {
+      send_segment( flow, std::move( *msg ) );
+    }
+    if ( auto ack = flow.receiver.maybe_send( flow.inbound.writer(), flow.reassembler ) ) {
+      send_ack( flow, *ack );
+    }
+    flow.stats.sequence_numbers_retransmitted = flow.sender.sequence_numbers_retransmitted();
+  }
+
+  // frames the interfaces made onto the links
+  for ( Host& host : hosts_ ) {
+    while ( auto frame = host.interface.maybe_send() ) {
+      host.uplink.send( std::move( *frame ), now_us );
+    }
+    while ( auto frame = host.router_port.maybe_send() ) {
+      host.downlink.send( std::move( *frame ), now_us );
+    }
+  }
+
+  timers_.advance( 1 );
+  for ( Flow& flow : flows_ ) {
+    if ( now_ms() > flow.config.start_ms ) {
+      flow.receiver.tick( 1, flow.reassembler, flow.inbound.writer() );
+    }
+  }
+}
+
+bool NetworkSimulator::run_until_done( uint64_t max_ms )
+{
+  const uint64_t deadline = now_ms() + max_ms;
+  while ( flows_completed_ < flows_.size() ) {
+    if ( now_ms() >= deadline ) {
+      return false;
+    }
+    tick();
+  }
+  return true;
+}
+
+void NetworkSimulator::write( Flow& flow )
+{
+  Writer& writer = flow.outbound.writer();
+  while ( writer.available_capacity() > 0 && writer.bytes_pushed() < flow.config.bytes ) {
+    const uint64_t remaining = flow.config.bytes - writer.bytes_pushed();
+    writer.push( remaining >= chunk_.size() ? chunk_ : chunk_.substr( 0, remaining ) );
+  }
+  if ( writer.bytes_pushed() == flow.config.bytes && !writer.is_closed() ) {
+    writer.close();
+  }
+}
+
+void NetworkSimulator::read( Flow& flow )
+{
+  Reader& reader = flow.inbound.reader();
+  flow.stats.bytes_delivered += reader.bytes_buffered();
+  reader.pop( reader.bytes_buffered() );
+  if ( reader.is_finished() && !flow.stats.completed_ms.has_value() ) {
+    flow.stats.completed_ms = now_ms();
+    ++flows_completed_;
+  }
+}
+
+void NetworkSimulator::send_segment( Flow& flow, const TCPSenderMessage& msg )
+{
+  ++flow.stats.segments_sent;
+  TCPSegment segment;
+  segment.message = msg;
+  send_from( flow.from, flow.to, flow.index, std::move( segment ) );
+}
+
+void NetworkSimulator::send_ack( Flow& flow, const TCPReceiverMessage& msg )
+{
+  // the window scale option only goes on a SYN, and no SYN comes back here, so the shift is kept by the flow
+  flow.window_scale = msg.window_scale;
+  TCPSegment segment;
+  segment.reply = msg;
+  send_from( flow.to, flow.from, flow.index, std::move( segment ) );
+}
+
+void NetworkSimulator::send_from( size_t host, size_t to_host, size_t flow, TCPSegment segment )
+{
+  // a flow is the same port number at both ends
+  segment.source_port = static_cast<uint16_t>( flow );
+  segment.destination_port = static_cast<uint16_t>( flow );
+
+  InternetDatagram dgram;
+  dgram.header.src = host_ip( host );
+  dgram.header.dst = host_ip( to_host );
+  dgram.header.len = static_cast<uint16_t>( IPv4Header::LENGTH + segment.serialized_length() );
+  dgram.header.compute_checksum();
+  segment.compute_checksum( dgram.header.pseudo_checksum() );
+  dgram.payload = serialize( segment );
+  hosts_[host].interface.send_datagram( dgram, Address::from_ipv4_numeric( router_ip() ) );
+}
+
+void NetworkSimulator::route( InternetDatagram dgram )
+{
+  const auto destination = host_by_ip_.find( dgram.header.dst );
+  if ( dgram.header.ttl <= 1 || destination == host_by_ip_.end() ) {
+    return;
+  }
+  --dgram.header.ttl;
+  dgram.header.compute_checksum();
+  hosts_[destination->second].router_port.send_datagram( dgram, Address::from_ipv4_numeric( dgram.header.dst ) );
+}
+
+void NetworkSimulator::receive( const InternetDatagram& dgram )
+{
+  TCPSegment segment;
+  Parser parser { dgram.payload };
+  segment.parse( parser, dgram.header.pseudo_checksum() );
+  if ( parser.has_error() || segment.destination_port >= flows_.size() ) {
+    return;
+  }
+
+  // data goes to the flow's destination, and acks come back to its source
+  Flow& flow = flows_[segment.destination_port];
+  if ( dgram.header.dst == host_ip( flow.to ) ) {
+    flow.receiver.receive( std::move( segment.message ), flow.reassembler, flow.inbound.writer() );
+    read( flow );
+    if ( auto ack = flow.receiver.maybe_send( flow.inbound.writer(), flow.reassembler ) ) {
+      send_ack( flow, *ack );
+    }
+  } else {
+    segment.reply.window_scale = flow.window_scale;
+    flow.sender.receive( segment.reply );
+  }
+}
+
+const NetworkSimulator::FlowStats& NetworkSimulator::flow_stats( size_t flow ) const
+{
+  return flows_.at( flow ).stats;
+}
+
+double NetworkSimulator::goodput_bps( size_t flow_index ) const
+{
+  const Flow& flow = flows_.at( flow_index );
+  const uint64_t end_ms = flow.stats.completed_ms.value_or( now_ms() );
+  if ( end_ms <= flow.config.start_ms ) {
+    return 0;
+  }
+  return static_cast<double>( flow.stats.bytes_delivered ) * 8 * 1000
+         / static_cast<double>( end_ms - flow.config.start_ms );
+}
+
+double NetworkSimulator::fairness() const
+{
+  double sum = 0;
+  double sum_of_squares = 0;
+  size_t started = 0;
+  for ( size_t i = 0; i < flows_.size(); ++i ) {
+    if ( now_ms() <= flows_[i].config.start_ms ) {
+      continue;
+    }
+    const double goodput = goodput_bps( i );
+    sum += goodput;
+    sum_of_squares += goodput * goodput;
+    ++started;
+  }
+  if ( sum_of_squares == 0 ) {
+    return 1;
+  }
+  return sum * sum / ( static_cast<double>( started ) * sum_of_squares );
+}
+
+const NetworkSimulator::LinkStats& NetworkSimulator::uplink_stats( size_t host ) const
+{
+  return hosts_.at( host ).uplink.stats();
+}
+
+const NetworkSimulator::LinkStats& NetworkSimulator::downlink_stats( size_t host ) const
+{
+  return hosts_.at( host ).downlink.stats();
+}
+
+uint64_t NetworkSimulator::arp_datagrams_queued() const
+{
+  uint64_t queued = 0;
+  for ( const Host& host : hosts_ ) {
+    queued += host.interface.datagrams_queued() + host.router_port.datagrams_queued();
+  }
+  return queued;
+}
+
+uint64_t NetworkSimulator::arp_datagrams_dropped() const
+{
+  uint64_t dropped = 0;
+  for ( const Host& host : hosts_ ) {
+    dropped += host.interface.datagrams_dropped() + host.router_port.datagrams_dropped();
+  }
+  return dropped;
+}
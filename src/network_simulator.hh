@@ -0,0 +1,164 @@
+#pragma once
+
+#include "byte_stream.hh"
+#include "network_interface.hh"
+#include "reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "timer_wheel.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+
+/*
+ * A deterministic discrete-event simulator for many TCP flows in one process. Every host hangs off one router by
+ * a link in each direction, and both ends of those links are NetworkInterfaces, so datagrams cross them as
+ * Ethernet frames and next hops are found with ARP. A link serializes frames at its bandwidth, keeps at most
+ * its queue depth of bytes waiting behind the frame being sent (a frame that doesn't fit is dropped), and
+ * delivers each one its delay after it has been sent.
+ *
+ * A flow moves a number of bytes from one host to another, with a TCPSender at the source and a TCPReceiver at
+ * the destination, which exchange TCPSegments on one port number; their applications write as fast as the
+ * stream allows and read everything that arrives.
+ * Time is virtual and advances in 1 ms ticks on one TimerWheel that every sender and interface shares, so a
+ * tick costs the traffic it carries and a constant per flow, not a scan of every timer.
+ */
+class NetworkSimulator
+{
+public:
+  struct LinkConfig
+  {
+    uint64_t bits_per_second;
+    uint64_t delay_ms;
+    uint64_t queue_bytes; // drop-tail queue depth
+  };
+
+  struct FlowConfig
+  {
+    uint64_t bytes;                                    // what the source writes before closing its stream
+    uint64_t start_ms {};                              // when it starts writing
+    uint64_t capacity { TCPConfig::DEFAULT_CAPACITY }; // of the stream at either end
+    std::function<void( TCPSender&, TCPReceiver& )> configure {}; // e.g. congestion control, before the start
+  };
+
+  // What a link has carried, and how long frames waited for it
+  struct LinkStats
+  {
+    uint64_t frames_sent {};
+    uint64_t bytes_sent {};
+    uint64_t frames_dropped {};    // the queue was full
+    uint64_t queueing_delay_us {}; // summed over the frames sent
+    uint64_t max_queueing_delay_us {};
+
+    double mean_queueing_delay_ms() const;
+  };
+
+  struct FlowStats
+  {
+    uint64_t bytes_delivered {}; // read by the destination's application
+    uint64_t segments_sent {};
+    uint64_t sequence_numbers_retransmitted {};
+    std::optional<uint64_t> completed_ms {}; // when the destination read the end of the stream
+  };
+
+  NetworkSimulator() = default;
+
+  // Neither copyable nor movable: every sender and interface keeps a pointer to its timer wheel
+  NetworkSimulator( const NetworkSimulator& ) = delete;
+  NetworkSimulator& operator=( const NetworkSimulator& ) = delete;
+  NetworkSimulator( NetworkSimulator&& ) = delete;
+  NetworkSimulator& operator=( NetworkSimulator&& ) = delete;
+  ~NetworkSimulator() = default;
+
+  // Attach a host to the router, and return its index
+  size_t add_host( const LinkConfig& uplink, const LinkConfig& downlink );
+
+  // Start a flow between two hosts (at config.start_ms), and return its index, which is also its port number
+  size_t add_flow( size_t from_host, size_t to_host, FlowConfig config );
+
+  void tick();                            // Advance virtual time by 1 ms
+  bool run_until_done( uint64_t max_ms ); // Tick until every flow has completed; false if they didn't in time
+  uint64_t now_ms() const { return timers_.now(); }
+
+  const FlowStats& flow_stats( size_t flow ) const;
+  double goodput_bps( size_t flow ) const; // bits delivered per second from its start until it completed (or now)
+  double fairness() const; // Jain's index of the started flows' goodputs: 1 if all equal, 1/n if one takes all
+
+  const LinkStats& uplink_stats( size_t host ) const;   // host to router
+  const LinkStats& downlink_stats( size_t host ) const; // router to host
+
+  uint64_t arp_datagrams_queued() const;  // held for an ARP reply, by any interface
+  uint64_t arp_datagrams_dropped() const; // dropped while waiting for one
+
+private:
+  // One direction of a link
+  class Link
+  {
+    struct InFlight
+    {
+      uint64_t arrival_us;
+      EthernetFrame frame;
+    };
+
+    LinkConfig config_;
+    uint64_t busy_until_us_ { 0 }; // when the frames sent so far will all have been serialized
+    std::queue<InFlight> in_flight_ {};
+    LinkStats stats_ {};
+
+  public:
+    explicit Link( const LinkConfig& config ) : config_( config ) {}
+
+    void send( EthernetFrame frame, uint64_t now_us );
+    std::optional<EthernetFrame> receive( uint64_t now_us ); // the next frame that has arrived by now
+    const LinkStats& stats() const { return stats_; }
+  };
+
+  struct Host
+  {
+    NetworkInterface interface;
+    NetworkInterface router_port; // the router's interface on this host's links
+    Link uplink;
+    Link downlink;
+  };
+
+  struct Flow
+  {
+    size_t index;
+    size_t from;
+    size_t to;
+    FlowConfig config;
+    ByteStream outbound;
+    TCPSender sender;
+    ByteStream inbound;
+    Reassembler reassembler {};
+    TCPReceiver receiver {};
+    FlowStats stats {};
+    uint8_t window_scale {}; // the receiver's shift, which a handshake would carry back on the SYN-ACK
+  };
+
+  TimerWheel timers_ {};
+  std::deque<Host> hosts_ {}; // a deque, so neither hosts nor flows move once their timers exist
+  std::deque<Flow> flows_ {};
+  std::unordered_map<uint32_t /* ipv4 numeric */, size_t> host_by_ip_ {};
+  size_t flows_completed_ { 0 };
+  std::string chunk_ = std::string( 1 << 16, 'x' ); // what the applications write
+
+  static uint32_t host_ip( size_t host );
+  static uint32_t router_ip();
+
+  void send_segment( Flow& flow, const TCPSenderMessage& msg );
+  void send_ack( Flow& flow, const TCPReceiverMessage& msg );
+  void send_from( size_t host, size_t to_host, size_t flow, TCPSegment segment );
+  void route( InternetDatagram dgram );        // forward a datagram the router received
+  void receive( const InternetDatagram& dgram ); // hand a datagram a host received to its flow
+  void write( Flow& flow );
+  void read( Flow& flow );
+};
@@ -1,154 +1,198 @@
 #include "reassembler.hh"
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
 using namespace std;
 
+static constexpr uint64_t WORD_BITS = 64;
+
+// bits [first, last) of a bitmap word, where first < last <= WORD_BITS
+static inline uint64_t word_mask( uint64_t first, uint64_t last )
+{
+  const uint64_t upper = last == WORD_BITS ? ~uint64_t { 0 } : ( uint64_t { 1 } << last ) - 1;
+  return upper & ~( ( uint64_t { 1 } << first ) - 1 );
+}
+
 bool Reassembler::is_closed() const
 {
-  return closed_ && bytes_pending() == 0;
+  return end_index_.has_value() && unassembled_index_ >= *end_index_;
 }
 
-void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring, Writer& output )
+void Reassembler::resize_ring( uint64_t capacity )
 {
-  if ( is_last_substring ) {
-    closed_ = true;
+  const auto blocks = received_blocks( SIZE_MAX ); // pending bytes move to their slots in the new ring
+
+  // fresh containers, so shrinking the ring also releases its memory
+  const string old_ring = exchange( ring_, string( capacity, '\0' ) );
+  present_ = vector<uint64_t>( ( capacity + WORD_BITS - 1 ) / WORD_BITS );
+  unassembled_bytes_ = 0;
+
+  for ( const auto& [first, last] : blocks ) {
+    for ( uint64_t index = first; index < last; ) {
+      const uint64_t pos = index % old_ring.size();
+      const uint64_t len = min( last - index, old_ring.size() - pos );
+      store( index, string_view( old_ring ).substr( pos, len ) );
+      index += len;
+    }
   }
+}
 
-  /* handle edge cases
-   * 1. data is empty
-   * 2. available capacity is 0
-   * 3. when it is already been buffered in bytestream and no need to assemble
-   * 4. When it is an unacceptable bytes
-   */
-  if ( data.empty() || output.available_capacity() == 0 || first_index + data.length() - 1 < unassembled_index_
-       || unassembled_index_ + output.available_capacity() <= first_index ) {
+uint64_t Reassembler::mark_present( uint64_t first, uint64_t last )
+{
+  uint64_t newly_present = 0;
+  while ( first < last ) {
+    const uint64_t bit = first % WORD_BITS;
+    const uint64_t end_bit = min( WORD_BITS, bit + last - first );
+    const uint64_t mask = word_mask( bit, end_bit );
+    uint64_t& word = present_[first / WORD_BITS];
+    newly_present += popcount( mask & ~word );
+    word |= mask;
+    first += end_bit - bit;
+  }
+  return newly_present;
+}
 
-    if ( is_closed() ) {
-      output.close();
-    }
-    return;
+uint64_t Reassembler::clear_present( uint64_t first, uint64_t last )
+{
+  uint64_t was_present = 0;
+  while ( first < last ) {
+    const uint64_t bit = first % WORD_BITS;
+    const uint64_t end_bit = min( WORD_BITS, bit + last - first );
+    const uint64_t mask = word_mask( bit, end_bit );
+    uint64_t& word = present_[first / WORD_BITS];
+    was_present += popcount( mask & word );
+    word &= ~mask;
+    first += end_bit - bit;
   }
+  return was_present;
+}
 
-  /*
-   * Make the data fit into the capacity
-   */
-  const uint64_t capacity = output.available_capacity(); // easier to type.
-  uint64_t new_index = first_index;                      // where the current data start.
-
-  if ( unassembled_index_ >= first_index ) { // when it has part in bytestream
-    new_index = unassembled_index_;          // we ignore the part already in byte stream
-    const uint64_t overlapped_length
-      = unassembled_index_ - first_index; // calculate the part already in Bytestream.
-    data
-      = data.substr( overlapped_length,
-                     min( data.size() - overlapped_length,
-                          capacity ) ); // then only get the data that is in capacity, or all the data if it fits.
-  } else {
-    // then the data is either all in Reassembler's or part in reassembler and part is unacceptable.
-    data = data.substr( 0, min( capacity, data.size() ) ); // data is all in reassembler
-    if ( first_index + data.size() - 1
-         > unassembled_index_ + capacity - 1 ) { // data is partially in, then only get the part in capacity
-      data = data.substr( 0, unassembled_index_ + capacity - first_index );
+uint64_t Reassembler::run_length( uint64_t first, uint64_t last, bool present ) const
+{
+  uint64_t pos = first;
+  while ( pos < last ) {
+    const uint64_t bit = pos % WORD_BITS;
+    const uint64_t word = present_[pos / WORD_BITS];
+    const uint64_t changed = ( present ? ~word : word ) >> bit;
+    if ( changed != 0 ) { // the state flips somewhere in the rest of this word
+      pos += countr_zero( changed );
+      break;
     }
+    pos += WORD_BITS - bit;
   }
+  return min( pos, last ) - first;
+}
 
-  /*
-   *  when the current data overlapped with the rear data
-   */
-  auto rear_iter
-    = unassembled_substrings_.lower_bound( new_index );  // find the first substring that is after the new_index
-  while ( rear_iter != unassembled_substrings_.end() ) { // iterate through the end
-    auto& [rear_index, rear_data] = *rear_iter;          // get the start index and its substrings
-    if ( new_index + data.size() - 1 < rear_index ) {    // if it has no overlapp with the later substring
+uint64_t Reassembler::stream_run( uint64_t first_index, uint64_t last_index, bool present ) const
+{
+  uint64_t index = first_index;
+  while ( index < last_index ) {
+    const uint64_t pos = index % ring_.size();
+    const uint64_t part = min( last_index - index, ring_.size() - pos );
+    const uint64_t len = run_length( pos, pos + part, present );
+    index += len;
+    if ( len < part ) {
       break;
     }
-    uint64_t rear_overlapped_length = 0;
-    if ( new_index + data.size() - 1
-         < rear_index + rear_data.size() - 1 ) { // partially overlapped, rear index is further behind
-      rear_overlapped_length = new_index + data.size() - rear_index;
-    } else {
-      rear_overlapped_length = rear_data.size(); // all overlapped
-    }
+  }
+  return index - first_index;
+}
 
-    // prepare for the next iteration
-    const uint64_t next_rear = rear_index + rear_data.size() - 1;
-    if ( rear_overlapped_length
-         == rear_data.size() ) { // when the rear_data is fully overlapped we delete the length and erase it;
-      unassembled_bytes_ -= rear_data.size();
-      unassembled_substrings_.erase( rear_index );
-    } else {
-      // only partially overalapped, we only delete the overlapped part.
-      data.erase( data.end() - static_cast<int64_t>( rear_overlapped_length ), data.end() );
-    }
+void Reassembler::store( uint64_t first_index, string_view data )
+{
+  // copy into the ring, splitting at the wrap point, and record which positions are now filled
+  while ( !data.empty() ) {
+    const uint64_t pos = first_index % ring_.size();
+    const uint64_t len = min( static_cast<uint64_t>( data.size() ), ring_.size() - pos );
+    data.copy( ring_.data() + pos, len );
+    unassembled_bytes_ += mark_present( pos, pos + len );
+    data.remove_prefix( len );
+    first_index += len;
+  }
+}
 
-    // searh for the next closest substring
-    rear_iter = unassembled_substrings_.lower_bound( next_rear );
+uint64_t Reassembler::discard( uint64_t first_index, uint64_t len )
+{
+  uint64_t discarded = 0;
+  while ( len > 0 ) {
+    const uint64_t pos = first_index % ring_.size();
+    const uint64_t part = min( len, ring_.size() - pos );
+    discarded += clear_present( pos, pos + part );
+    len -= part;
+    first_index += part;
   }
+  return discarded;
+}
 
-  /*
-   * when the current data overlapped with the front data
-   */
-  if ( first_index > unassembled_index_ ) {
-    auto front_iter = unassembled_substrings_.upper_bound( new_index );
-    if ( front_iter != unassembled_substrings_.begin() ) {
-      front_iter--;
-      const auto& [front_index, front_data] = *front_iter;
-      if ( front_index + front_data.size() - 1 >= first_index ) { // check if there is an overlapped
-        uint64_t overlapped_length = 0;
-        if ( front_index + front_data.size()
-             <= first_index + data.size() ) { // if there is an partially overalapped
-          overlapped_length = front_index + front_data.size() - first_index;
-        } else {
-          overlapped_length = data.size(); // else the data is all overalapped in the front part;
-        }
-        if ( overlapped_length == front_data.size() ) { // if all overlapped then nothing is stored
-          unassembled_bytes_ -= front_data.size();
-          unassembled_substrings_.erase( front_index );
-        } else {
-          data.erase( data.begin(),
-                      data.begin()
-                        + static_cast<int64_t>( overlapped_length ) ); // else only erase the overlapped part
-          new_index = first_index + overlapped_length;
-        }
-      }
-    }
+void Reassembler::fit_to( const Writer& output )
+{
+  // the ring covers the whole stream capacity, so every acceptable byte has a slot of its own
+  uint64_t capacity = output.available_capacity() + output.reader().bytes_buffered();
+  if ( memory_budget_.has_value() ) { // unless the budget says otherwise: 1 byte + 1 bit per slot
+    const uint64_t slots = *memory_budget_ / 9 * 8; // not budget * 8 / 9, which overflows for huge budgets
+    capacity = min( capacity, slots / WORD_BITS * WORD_BITS );
+  }
+  // growing keeps every pending byte in reach; shrinking waits until there are none
+  if ( capacity > ring_.size() || ( capacity < ring_.size() && unassembled_bytes_ == 0 ) ) {
+    resize_ring( capacity );
+  }
+}
+
+void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring, Writer& output )
+{
+  if ( is_last_substring ) {
+    end_index_ = first_index + data.size();
   }
 
-  /**
-   * push data to the output byte stream, and update our unassembled_substring since we pushed some bytes to the
-   * bytestream
-   *
-   */
-  if ( data.size() > 0 ) {
-    unassembled_bytes_ += data.size();
-    unassembled_substrings_.insert( make_pair( new_index, std::move( data ) ) );
+  fit_to( output );
+
+  ++total_inserts_;
+  if ( first_index <= unassembled_index_ && unassembled_index_ < first_index + data.size() ) {
+    /*
+     * Fast path: the segment continues the stream, so hand it to the output without staging it in the ring
+     */
+    ++fast_path_inserts_;
+    data.erase( 0, unassembled_index_ - first_index );
+    data.resize( min( static_cast<uint64_t>( data.size() ), output.available_capacity() ) );
+    if ( unassembled_bytes_ > 0 ) { // earlier copies of these bytes may be waiting in the ring
+      unassembled_bytes_ -= discard( unassembled_index_, data.size() );
+    }
+    unassembled_index_ += data.size();
+    output.push( std::move( data ) );
+  } else {
+    /*
+     * Keep only the part of the data that is not yet in the stream and fits in its available capacity
+     */
+    const uint64_t first = max( first_index, unassembled_index_ );
+    const uint64_t acceptable = min( first_index + data.size(), unassembled_index_ + output.available_capacity() );
+    const uint64_t last = min( acceptable, unassembled_index_ + ring_.size() );
+    if ( first < last ) {
+      store( first, string_view( data ).substr( first - first_index, last - first ) );
+    }
+    if ( max( first, last ) < acceptable ) { // the ring is smaller than the window: over budget
+      bytes_dropped_ += acceptable - max( first, last );
+    }
   }
 
-  for ( auto iter = unassembled_substrings_.begin(); iter != unassembled_substrings_.end(); ) {
-    auto& [sub_index, sub_data] = *iter;
-    if ( sub_index == unassembled_index_ ) {
-      const uint64_t prev_bytes_pushed = output.bytes_pushed();
-      output.push( sub_data );
-      const uint64_t bytes_pushed = output.bytes_pushed();
-      if ( prev_bytes_pushed + sub_data.size()
-           != bytes_pushed ) { // we cannot push all the data since it reach capacity
-        const uint64_t pushed_length = bytes_pushed - prev_bytes_pushed;
-        unassembled_bytes_ -= pushed_length; // we already assembled the pushed length
-        unassembled_index_ += pushed_length; // update the sliding window;
-        unassembled_substrings_.insert( make_pair(
-          unassembled_index_,
-          sub_data.substr( pushed_length ) ) ); // create a new unassembled substring part minus the pushed_bytes
-        unassembled_substrings_.erase( sub_index ); // erase the old one
-        break;
-      }
-      // then we can push all the sub_data size
-      unassembled_bytes_ -= sub_data.size();
-      unassembled_index_ += sub_data.size();
-      unassembled_substrings_.erase( sub_index );
-      iter = unassembled_substrings_.find( unassembled_index_ );
-
-    } else {
+  /*
+   * Push the stored run of bytes that now continues the stream (at most two pieces of the ring)
+   */
+  string assembled;
+  while ( unassembled_bytes_ > 0 ) {
+    const uint64_t pos = unassembled_index_ % ring_.size();
+    const uint64_t len = run_length( pos, ring_.size(), true );
+    if ( len == 0 ) {
       break;
     }
+    unassembled_bytes_ -= clear_present( pos, pos + len );
+    assembled.append( ring_, pos, len );
+    unassembled_index_ += len;
+  }
+  if ( !assembled.empty() ) {
+    output.push( std::move( assembled ) );
   }
 
   if ( is_closed() ) {
@@ -159,4 +203,30 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
 uint64_t Reassembler::bytes_pending() const
 {
   return unassembled_bytes_;
-}
\ No newline at end of file
+}
+
+vector<pair<uint64_t, uint64_t>> Reassembler::received_blocks( size_t max_blocks ) const
+{
+  vector<pair<uint64_t, uint64_t>> blocks;
+  const uint64_t window_end = unassembled_index_ + ring_.size();
+  uint64_t index = unassembled_index_;
+  uint64_t bytes_seen = 0;
+  while ( blocks.size() < max_blocks && bytes_seen < unassembled_bytes_ ) {
+    index += stream_run( index, window_end, false ); // skip the hole
+    const uint64_t len = stream_run( index, window_end, true );
+    blocks.emplace_back( index, index + len );
+    index += len;
+    bytes_seen += len;
+  }
+  return blocks;
+}
+
+uint64_t Reassembler::memory_usage() const
+{
+  return ring_.capacity() + present_.capacity() * sizeof( uint64_t );
+}
+
+uint64_t Reassembler::memory_allocations() const
+{
+  return ( ring_.capacity() > string {}.capacity() ) + ( present_.capacity() > 0 );
+}
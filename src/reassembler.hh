@@ -1,17 +1,41 @@
 #pragma once
 
 #include "byte_stream.hh"
-#include <map>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 class Reassembler
 {
 private:
   uint64_t unassembled_index_ { 0 };
   uint64_t unassembled_bytes_ { 0 };
-  std::map<uint64_t, std::string> unassembled_substrings_ {};
-  bool closed_ { false };
+  std::optional<uint64_t> end_index_ {}; // stream index just past the last byte, once known
+
+  // Bytes above `unassembled_index_` live in a ring sized to the stream's capacity (or the memory budget):
+  // stream index `i` is stored at `i % ring_.size()`. Bit `i % ring_.size()` of `present_` says whether it
+  // has arrived.
+  std::string ring_ {};
+  std::vector<uint64_t> present_ {};
+  std::optional<uint64_t> memory_budget_ {}; // cap on the bytes held by `ring_` and `present_`
+
+  uint64_t total_inserts_ { 0 };
+  uint64_t fast_path_inserts_ { 0 };
+  uint64_t bytes_dropped_ { 0 };
+
   bool is_closed() const;
+  void resize_ring( uint64_t capacity );
+  uint64_t mark_present( uint64_t first, uint64_t last );  // set ring positions [first, last), count new ones
+  uint64_t clear_present( uint64_t first, uint64_t last ); // clear ring positions [first, last), count old ones
+
+  // length of the run of present (or absent) ring positions from `first`, stopping at `last`
+  uint64_t run_length( uint64_t first, uint64_t last, bool present ) const;
+  // the same for stream indices, following the ring around its wrap point
+  uint64_t stream_run( uint64_t first_index, uint64_t last_index, bool present ) const;
+
+  void store( uint64_t first_index, std::string_view data );
+  uint64_t discard( uint64_t first_index, uint64_t len ); // forget stored bytes the stream now has, count them
 
 public:
   /*
@@ -36,6 +60,28 @@ public:
    */
   void insert( uint64_t first_index, std::string data, bool is_last_substring, Writer& output );
 
+  // Size the storage for out-of-order bytes to the stream's capacity, as insert() does. It grows at once, keeping
+  // the bytes already stored, but shrinks only once none are pending.
+  void fit_to( const Writer& output );
+
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
+
+  // How many insert() calls were made, and how many of them went straight to the output (in-order fast path)?
+  uint64_t total_inserts() const { return total_inserts_; }
+  uint64_t fast_path_inserts() const { return fast_path_inserts_; }
+
+  /*
+   * Limit the memory used to hold out-of-order bytes. Bytes that would need more than `bytes` of storage
+   * (the ones furthest from the stream's next index) are dropped and counted in bytes_dropped(); in-order
+   * segments are unaffected. A smaller budget takes effect once nothing is pending.
+   */
+  void set_memory_budget( uint64_t bytes ) { memory_budget_ = bytes; }
+
+  uint64_t memory_usage() const;       // Heap bytes held for pending data, bookkeeping included
+  uint64_t memory_allocations() const; // Number of heap blocks behind memory_usage()
+  uint64_t bytes_dropped() const { return bytes_dropped_; } // Acceptable bytes dropped to honor the budget
+
+  // The first `max_blocks` runs of stored bytes, as [first, last) stream indices in increasing order
+  std::vector<std::pair<uint64_t, uint64_t>> received_blocks( size_t max_blocks ) const;
 };
\ No newline at end of file
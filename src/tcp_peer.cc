@@ -0,0 +1,130 @@
+#include "tcp_peer.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+using namespace std;
+
+TCPPeer::TCPPeer( const TCPConfig& config )
+  : outbound_( config.send_capacity )
+  , sender_( config.rt_timeout, config.fixed_isn, config.mss )
+  , inbound_( config.recv_capacity )
+  , window_scale_( TCPConfig::window_scale_for( config.recv_capacity ) )
+{
+  sender_.enable_window_scaling();
+  receiver_.set_window_scale( window_scale_ );
+}
+
+void TCPPeer::push()
+{
+  if ( !reset_ ) {
+    sender_.push( outbound_.reader() );
+    opened_ = true;
+  }
+}
+
+void TCPPeer::push_if_open()
+{
+  if ( opened_ ) {
+    push();
+  }
+}
+
+// Does `reply` tell the sender nothing that `last` didn't?
+static bool same_ack( const TCPReceiverMessage& last, const TCPReceiverMessage& reply )
+{
+  return last.ackno == reply.ackno && last.window_size == reply.window_size
+         && last.sack_blocks == reply.sack_blocks;
+}
+
+void TCPPeer::receive( TCPSegment segment )
+{
+  if ( reset_ ) {
+    return;
+  }
+  if ( segment.RST ) {
+    reset();
+    return;
+  }
+
+  // the window scale option comes only on the other end's SYN, whose own window isn't scaled (RFC 7323)
+  if ( segment.message.SYN ) {
+    peer_window_scale_ = segment.message.window_scaling ? segment.reply.window_scale : 0;
+  }
+  segment.reply.window_scale = segment.message.SYN ? 0 : peer_window_scale_;
+
+  // RFC 5681 only counts an ack that carries no data as a duplicate, so the sender isn't shown the ack on a data
+  // segment unless it says something new
+  const bool carries_data = segment.message.sequence_length() > 0;
+  if ( !carries_data || !last_reply_.has_value() || !same_ack( *last_reply_, segment.reply ) ) {
+    sender_.receive( segment.reply );
+    last_reply_ = std::move( segment.reply );
+    push_if_open(); // the ack may open the window, or release bytes that coalescing held back for it
+  }
+
+  // a pure ack uses no sequence numbers, and acknowledging it would start an endless exchange of acks
+  if ( carries_data ) {
+    receiver_.receive( std::move( segment.message ), reassembler_, inbound_.writer() );
+  }
+}
+
+optional<TCPSegment> TCPPeer::maybe_send()
+{
+  TCPSegment segment;
+  if ( reset_due_ ) {
+    reset_due_ = false;
+    segment.message = sender_.send_empty_message();
+    segment.RST = true;
+  } else if ( reset_ ) {
+    return {};
+  } else if ( auto msg = sender_.maybe_send() ) {
+    fin_sent_ |= msg->FIN;
+    segment.message = std::move( *msg );
+    // the current ack costs nothing here, even if none is due, and makes a delayed one unnecessary
+    segment.reply = receiver_.send_piggybacked( inbound_.writer(), reassembler_ );
+    acks_piggybacked_ += segment.reply.ackno.has_value();
+    if ( segment.message.SYN ) { // it offers the shift for this end's windows, and its own window is unscaled
+      segment.reply.window_scale = window_scale_;
+      segment.reply.window_size = static_cast<uint16_t>( min( inbound_.writer().available_capacity(),
+                                                              uint64_t { UINT16_MAX } ) );
+    }
+  } else if ( auto ack = receiver_.maybe_send( inbound_.writer(), reassembler_ ) ) {
+    segment.message = sender_.send_empty_message();
+    segment.reply = std::move( *ack );
+    ++pure_acks_sent_;
+  } else {
+    return {};
+  }
+
+  ++segments_sent_;
+  return segment;
+}
+
+void TCPPeer::tick( uint64_t ms_since_last_tick )
+{
+  sender_.tick( ms_since_last_tick );
+  receiver_.tick( ms_since_last_tick, reassembler_, inbound_.writer() );
+  if ( !reset_ && sender_.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS ) {
+    reset();
+    reset_due_ = true;
+  }
+  push_if_open(); // small writes held back by coalescing leave once they have waited the maximum delay
+}
+
+bool TCPPeer::active() const
+{
+  if ( reset_ ) {
+    return false;
+  }
+  const bool outbound_done
+    = outbound_.reader().is_finished() && fin_sent_ && sender_.sequence_numbers_in_flight() == 0;
+  return !outbound_done || !inbound_.reader().is_finished();
+}
+
+void TCPPeer::reset()
+{
+  reset_ = true;
+  outbound_.writer().set_error();
+  inbound_.writer().set_error();
+}
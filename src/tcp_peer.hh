@@ -0,0 +1,82 @@
+#pragma once
+
+#include "byte_stream.hh"
+#include "reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+
+#include <cstdint>
+#include <optional>
+
+/*
+ * One end of a TCP connection: a TCPSender for the outbound stream and a TCPReceiver (with its Reassembler) for
+ * the inbound one, exchanging TCPSegments with the other end. Every segment carries the receiver's ackno and
+ * window, so an ack that is due rides on the next data segment, and goes out on its own only when there is no
+ * data to send. Ports are left to whoever puts the segments on the network.
+ */
+class TCPPeer
+{
+public:
+  explicit TCPPeer( const TCPConfig& config );
+
+  Writer& outbound_writer() { return outbound_.writer(); } // what the application sends
+  Reader& inbound_reader() { return inbound_.reader(); }   // what it receives
+  const Writer& outbound_writer() const { return outbound_.writer(); }
+  const Reader& inbound_reader() const { return inbound_.reader(); }
+
+  // For configuration (e.g. congestion control or delayed acks) before the connection starts
+  TCPSender& sender() { return sender_; }
+  TCPReceiver& receiver() { return receiver_; }
+  const TCPSender& sender() const { return sender_; }
+  const TCPReceiver& receiver() const { return receiver_; }
+
+  /*
+   * Let the sender take what the application has written (the first push() sends the SYN). After that, receive()
+   * and tick() push too, so bytes that coalescing held back leave when the ack or the maximum delay comes.
+   */
+  void push();
+
+  /* Receive a segment from the other end: its ack goes to the sender, its data to the receiver */
+  void receive( TCPSegment segment );
+
+  /* The next segment to send, with the current ack on it, or empty if there is neither data nor an ack due */
+  std::optional<TCPSegment> maybe_send();
+
+  /* Time has passed by the given # of milliseconds since the last time the tick() method was called */
+  void tick( uint64_t ms_since_last_tick );
+
+  /*
+   * Is the connection still open? It closes once both streams have ended and everything sent was acknowledged,
+   * or when it is reset: by the other end, or by this one after TCPConfig::MAX_RETX_ATTEMPTS retransmissions
+   * in a row. An ack (or RST) that is still due can be had from maybe_send() afterwards.
+   */
+  bool active() const;
+
+  uint64_t segments_sent() const { return segments_sent_; }
+  uint64_t acks_piggybacked() const { return acks_piggybacked_; } // acks that rode on a data segment
+  uint64_t pure_acks_sent() const { return pure_acks_sent_; }     // segments that carried only an ack
+
+private:
+  ByteStream outbound_;
+  TCPSender sender_;
+  ByteStream inbound_;
+  Reassembler reassembler_ {};
+  TCPReceiver receiver_ {};
+  uint8_t window_scale_;            // offered on this end's SYN, for the windows its receiver reports
+  uint8_t peer_window_scale_ { 0 }; // from the other end's SYN, for the windows it reports
+
+  std::optional<TCPReceiverMessage> last_reply_ {}; // the last ack the sender was given
+  bool opened_ { false }; // push() was called, and the sender may send
+  bool fin_sent_ { false };
+  bool reset_ { false };
+  bool reset_due_ { false }; // an RST is still to be sent
+
+  uint64_t segments_sent_ { 0 };
+  uint64_t acks_piggybacked_ { 0 };
+  uint64_t pure_acks_sent_ { 0 };
+
+  void push_if_open();
+  void reset(); // fail both streams
+};
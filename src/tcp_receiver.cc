@@ -1,4 +1,6 @@
 #include "tcp_receiver.hh"
+#include "tcp_config.hh"
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
@@ -11,19 +13,196 @@ void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, W
     }
     set_syn_ = true;
     isn_ = message.seqno;
+    window_scale_ = message.window_scaling ? configured_window_scale_ : 0;
+    if ( autotuning_ ) {
+      inbound_stream.set_capacity( min_capacity_ );
+      start_round( inbound_stream );
+    }
   }
 
   uint64_t abs_seqno
     = message.seqno.unwrap( isn_, inbound_stream.bytes_pushed() + 1 ); // total bytes pushed + 1 is the next index;
   uint64_t start_index = abs_seqno + message.SYN - 1; // SYN occupied one seqno, isn_ occupy one index so minus one.
+  const uint64_t payload_size = message.payload.size();
+  const uint64_t pushed_before = inbound_stream.bytes_pushed();
+  const uint64_t pending_before = reassembler.bytes_pending();
   reassembler.insert( start_index, message.payload.release(), message.FIN, inbound_stream );
+  if ( autotuning_ ) {
+    ms_idle_ = 0;
+    if ( shrinking_ ) {
+      shrink_window( reassembler, inbound_stream );
+    } else {
+      grow_window( inbound_stream );
+    }
+  }
+
+  if ( !delayed_ack_ || message.SYN || message.FIN ) {
+    ack_now_ = true;
+    return;
+  }
+  if ( payload_size == 0 ) {
+    return; // nothing to acknowledge
+  }
+
+  // in order: all of it went straight to the stream, and there was no hole before or after
+  const bool in_order = pending_before == 0 && reassembler.bytes_pending() == 0
+                        && inbound_stream.bytes_pushed() - pushed_before == payload_size;
+  if ( !in_order ) {
+    ack_now_ = true;
+    return;
+  }
+  bytes_unacked_ += payload_size;
+  if ( bytes_unacked_ >= 2 * mss_ ) {
+    ack_now_ = true;
+  }
+}
+
+void TCPReceiver::enable_delayed_ack( uint64_t timeout_ms, uint64_t mss )
+{
+  delayed_ack_ = true;
+  delayed_ack_timeout_ms_ = timeout_ms;
+  mss_ = mss;
+}
+
+void TCPReceiver::tick( uint64_t ms_since_last_tick )
+{
+  if ( bytes_unacked_ > 0 ) {
+    ms_since_unacked_ += ms_since_last_tick;
+  }
+}
+
+void TCPReceiver::enable_window_autotuning( uint64_t min_capacity, uint64_t max_capacity, uint64_t idle_timeout_ms )
+{
+  autotuning_ = true;
+  min_capacity_ = min_capacity;
+  max_capacity_ = max( min_capacity, max_capacity );
+  idle_timeout_ms_ = idle_timeout_ms;
+}
+
+void TCPReceiver::tick( uint64_t ms_since_last_tick, Reassembler& reassembler, Writer& inbound_stream )
+{
+  tick( ms_since_last_tick );
+  if ( !autotuning_ || !set_syn_ ) {
+    return;
+  }
+
+  ms_idle_ += ms_since_last_tick;
+  // out-of-order bytes are stored by stream index, so the stream can't shrink under them
+  if ( ms_idle_ >= idle_timeout_ms_ && reassembler.bytes_pending() == 0
+       && inbound_stream.capacity() > min_capacity_ ) {
+    shrinking_ = true;
+  }
+  if ( shrinking_ ) {
+    shrink_window( reassembler, inbound_stream );
+  }
+}
+
+void TCPReceiver::start_round( Writer& inbound_stream )
+{
+  round_edge_ = inbound_stream.bytes_pushed() + inbound_stream.available_capacity();
+  round_start_popped_ = inbound_stream.reader().bytes_popped();
+}
+
+void TCPReceiver::grow_window( Writer& inbound_stream )
+{
+  if ( inbound_stream.bytes_pushed() < round_edge_ ) {
+    return;
+  }
+
+  // A whole window arrived. If the application read most of it meanwhile, the window held the sender back.
+  const uint64_t capacity = inbound_stream.capacity();
+  const uint64_t drained = inbound_stream.reader().bytes_popped() - round_start_popped_;
+  if ( drained >= capacity - capacity / 4 ) {
+    inbound_stream.set_capacity( min( 2 * capacity, max_capacity_ ) );
+  }
+  start_round( inbound_stream );
+}
+
+void TCPReceiver::shrink_window( Reassembler& reassembler, Writer& inbound_stream )
+{
+  // The sender may still fill the window it was offered (RFC 9293 3.8.6), so keep the advertised right edge
+  // where it is: the capacity only comes down as the application reads up to it.
+  const uint64_t popped = inbound_stream.reader().bytes_popped();
+  const uint64_t capacity = max( min_capacity_, window_edge_ - min( window_edge_, popped ) );
+  if ( capacity < inbound_stream.capacity() ) {
+    inbound_stream.set_capacity( capacity ); // or as little above it as the unread bytes allow
+    reassembler.fit_to( inbound_stream );
+  }
+  if ( inbound_stream.capacity() <= min_capacity_ ) {
+    shrinking_ = false;
+    start_round( inbound_stream );
+  }
+}
+
+bool TCPReceiver::window_update_due( const Writer& inbound_stream ) const
+{
+  const uint64_t window = uint64_t { send( inbound_stream ).window_size } << window_scale_;
+  const uint64_t offered = window_edge_ - min( window_edge_, inbound_stream.bytes_pushed() ); // still usable
+  const uint64_t capacity = inbound_stream.available_capacity() + inbound_stream.reader().bytes_buffered();
+  // worth an ack if the window has at least doubled and grown by min(half the buffer, one MSS)
+  const uint64_t threshold = max( uint64_t { 1 }, min( capacity / 2, mss_ ) );
+  return window >= offered + threshold && window >= 2 * offered;
+}
+
+bool TCPReceiver::should_ack( const Writer& inbound_stream ) const
+{
+  if ( !set_syn_ ) {
+    return false;
+  }
+  return ack_now_ || ( bytes_unacked_ > 0 && ms_since_unacked_ >= delayed_ack_timeout_ms_ )
+         || window_update_due( inbound_stream );
+}
+
+void TCPReceiver::note_ack_sent( const Writer& inbound_stream, const TCPReceiverMessage& msg )
+{
+  ack_now_ = false;
+  bytes_unacked_ = 0;
+  ms_since_unacked_ = 0;
+  window_edge_ = inbound_stream.bytes_pushed() + ( uint64_t { msg.window_size } << window_scale_ );
+  ++acks_sent_;
+}
+
+optional<TCPReceiverMessage> TCPReceiver::maybe_send( const Writer& inbound_stream )
+{
+  if ( !should_ack( inbound_stream ) ) {
+    return {};
+  }
+  TCPReceiverMessage msg = send( inbound_stream );
+  note_ack_sent( inbound_stream, msg );
+  return msg;
+}
+
+optional<TCPReceiverMessage> TCPReceiver::maybe_send( const Writer& inbound_stream, const Reassembler& reassembler )
+{
+  if ( !should_ack( inbound_stream ) ) {
+    return {};
+  }
+  TCPReceiverMessage msg = send( inbound_stream, reassembler );
+  note_ack_sent( inbound_stream, msg );
+  return msg;
+}
+
+TCPReceiverMessage TCPReceiver::send_piggybacked( const Writer& inbound_stream, const Reassembler& reassembler )
+{
+  TCPReceiverMessage msg = send( inbound_stream, reassembler );
+  if ( set_syn_ ) {
+    note_ack_sent( inbound_stream, msg );
+  }
+  return msg;
+}
+
+void TCPReceiver::set_window_scale( uint8_t shift )
+{
+  configured_window_scale_ = min( shift, TCPConfig::MAX_WINDOW_SCALE );
 }
 
 TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
 {
   TCPReceiverMessage msg;
-  uint16_t window_size
-    = inbound_stream.available_capacity() > UINT16_MAX ? UINT16_MAX : inbound_stream.available_capacity();
+  // the scaled window rounds down, so it never offers more than the stream can take
+  const uint64_t max_window = uint64_t { UINT16_MAX } << window_scale_;
+  const auto window_size
+    = static_cast<uint16_t>( min( inbound_stream.available_capacity(), max_window ) >> window_scale_ );
 
   if ( !set_syn_ ) {
     return { std::optional<Wrap32> {}, window_size };
@@ -37,5 +216,20 @@ TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
 
   msg.ackno = isn_ + abs_ackno_offset;
   msg.window_size = window_size;
+  msg.window_scale = window_scale_;
   return msg;
-}
\ No newline at end of file
+}
+
+TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream, const Reassembler& reassembler ) const
+{
+  TCPReceiverMessage msg = send( inbound_stream );
+  if ( !msg.ackno.has_value() ) {
+    return msg;
+  }
+
+  // stream index i is carried by absolute seqno i + 1 (the SYN takes absolute seqno 0)
+  for ( const auto& [first_index, last_index] : reassembler.received_blocks( TCPConfig::MAX_SACK_BLOCKS ) ) {
+    msg.sack_blocks.emplace_back( Wrap32::wrap( first_index + 1, isn_ ), Wrap32::wrap( last_index + 1, isn_ ) );
+  }
+  return msg;
+}
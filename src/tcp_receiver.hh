@@ -1,6 +1,7 @@
 #pragma once
 
 #include "reassembler.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
@@ -16,7 +17,81 @@ public:
   /* The TCPReceiver sends TCPReceiverMessages back to the TCPSender. */
   TCPReceiverMessage send( const Writer& inbound_stream ) const;
 
+  /* Same, but also report the blocks the Reassembler holds above the ackno as SACK blocks. */
+  TCPReceiverMessage send( const Writer& inbound_stream, const Reassembler& reassembler ) const;
+
+  /*
+   * Report windows in units of 2^shift (at most TCPConfig::MAX_WINDOW_SCALE), so a stream with more than
+   * UINT16_MAX bytes of capacity can advertise all of it. Only takes effect if the SYN offers window scaling.
+   */
+  void set_window_scale( uint8_t shift );
+
+  /*
+   * Delay acknowledgments (RFC 1122 4.2.3.2, RFC 5681 4.2): ack once two full segments of in-order data are
+   * unacknowledged, or `timeout_ms` after the first of them arrived. The SYN, the FIN, out-of-order or duplicate
+   * segments, segments that fill a hole and window updates are still acknowledged at once.
+   */
+  void enable_delayed_ack( uint64_t timeout_ms = 200, uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE );
+
+  /* Time has passed by the given # of milliseconds since the last time the tick() method was called. */
+  void tick( uint64_t ms_since_last_tick );
+
+  /*
+   * Tune the receive window by resizing the inbound stream between `min_capacity` and `max_capacity`. The
+   * capacity doubles whenever a whole window arrives while the application keeps draining the stream, and falls
+   * back to `min_capacity` once no segment has arrived for `idle_timeout_ms`: never pulling in the right edge of
+   * the last window advertised, it shrinks as the sender fills that window. Windows above UINT16_MAX bytes need
+   * set_window_scale().
+   */
+  void enable_window_autotuning( uint64_t min_capacity, uint64_t max_capacity, uint64_t idle_timeout_ms = 1000 );
+
+  /* Same as tick(), and let window auto-tuning shrink the stream (and Reassembler) of an idle connection. */
+  void tick( uint64_t ms_since_last_tick, Reassembler& reassembler, Writer& inbound_stream );
+
+  /* Is an ack due? Without delayed acks, every segment after the SYN is acknowledged. */
+  bool should_ack( const Writer& inbound_stream ) const;
+
+  /* If an ack is due, return it (as send() would) and start over; otherwise return nothing. */
+  std::optional<TCPReceiverMessage> maybe_send( const Writer& inbound_stream );
+  std::optional<TCPReceiverMessage> maybe_send( const Writer& inbound_stream, const Reassembler& reassembler );
+
+  /*
+   * The ack for a segment that goes out anyway, such as one carrying data: return it (as send() would) and, once
+   * the SYN has arrived, start over as maybe_send() does, so that no separate ack follows for what it covers.
+   */
+  TCPReceiverMessage send_piggybacked( const Writer& inbound_stream, const Reassembler& reassembler );
+
+  uint64_t acks_sent() const { return acks_sent_; } // by maybe_send() and send_piggybacked()
+
 private:
   bool set_syn_ { false };
   Wrap32 isn_ { 0 };
+  uint8_t configured_window_scale_ { 0 };
+  uint8_t window_scale_ { 0 }; // negotiated with the SYN
+
+  bool delayed_ack_ { false };
+  uint64_t delayed_ack_timeout_ms_ { 0 };
+  uint64_t mss_ { TCPConfig::MAX_PAYLOAD_SIZE };
+  bool ack_now_ { false };
+  uint64_t bytes_unacked_ { 0 };    // in-order payload bytes received since the last ack
+  uint64_t ms_since_unacked_ { 0 }; // since the first of them arrived
+  uint64_t window_edge_ { 0 };      // stream index just past the window advertised by the last ack
+  uint64_t acks_sent_ { 0 };
+
+  bool autotuning_ { false };
+  uint64_t min_capacity_ { 0 };
+  uint64_t max_capacity_ { 0 };
+  uint64_t idle_timeout_ms_ { 0 };
+  uint64_t ms_idle_ { 0 };            // since the last segment arrived
+  bool shrinking_ { false };          // idle: falling back to min_capacity_ behind the advertised window
+  uint64_t round_edge_ { 0 };         // a round ends once the window offered at its start has arrived
+  uint64_t round_start_popped_ { 0 }; // bytes the application had read when the round started
+
+  /* Has the window grown enough since the last ack to be worth announcing (RFC 1122 4.2.3.3)? */
+  bool window_update_due( const Writer& inbound_stream ) const;
+  void note_ack_sent( const Writer& inbound_stream, const TCPReceiverMessage& msg );
+
+  void start_round( Writer& inbound_stream );
+  void grow_window( Writer& inbound_stream );
+  void shrink_window( Reassembler& reassembler, Writer& inbound_stream );
 };
@@ -0,0 +1,198 @@
+#include "tcp_segment.hh"
+#include "checksum.hh"
+#include "tcp_config.hh"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+static constexpr uint8_t FLAG_FIN = 0x01;
+static constexpr uint8_t FLAG_SYN = 0x02;
+static constexpr uint8_t FLAG_RST = 0x04;
+static constexpr uint8_t FLAG_ACK = 0x10;
+
+static constexpr uint8_t OPTION_END = 0;
+static constexpr uint8_t OPTION_NOP = 1;
+static constexpr uint8_t OPTION_WINDOW_SCALE = 3;
+static constexpr uint8_t OPTION_SACK = 5;
+
+// Each option is padded with NOPs to a whole word: NOP, window scale (3 bytes), and NOP, NOP, SACK (2 + 8n bytes)
+static constexpr size_t WINDOW_SCALE_LENGTH = 4;
+static constexpr size_t SACK_BASE_LENGTH = 4;
+static constexpr size_t SACK_BLOCK_LENGTH = 8;
+
+static uint32_t raw( Wrap32 n )
+{
+  return static_cast<uint32_t>( n.unwrap( Wrap32 { 0 }, 0 ) );
+}
+
+static uint32_t big_endian( string_view bytes )
+{
+  uint32_t n = 0;
+  for ( const char byte : bytes ) {
+    n = n << 8 | static_cast<uint8_t>( byte );
+  }
+  return n;
+}
+
+static bool window_scale_sent( const TCPSegment& segment )
+{
+  return segment.message.SYN and segment.message.window_scaling;
+}
+
+static size_t sack_blocks_sent( const TCPSegment& segment )
+{
+  const size_t space = TCPSegment::MAX_OPTIONS_LENGTH - ( window_scale_sent( segment ) ? WINDOW_SCALE_LENGTH : 0 );
+  return min( segment.reply.sack_blocks.size(), ( space - SACK_BASE_LENGTH ) / SACK_BLOCK_LENGTH );
+}
+
+size_t TCPSegment::header_length() const
+{
+  const size_t blocks = sack_blocks_sent( *this );
+  return TCPConfig::TCP_HEADER_LENGTH + ( window_scale_sent( *this ) ? WINDOW_SCALE_LENGTH : 0 )
+         + ( blocks ? SACK_BASE_LENGTH + blocks * SACK_BLOCK_LENGTH : 0 );
+}
+
+void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
+{
+  checksum = 0;
+  Serializer s;
+  serialize( s );
+
+  InternetChecksum check { datagram_layer_pseudo_checksum };
+  check.add( s.output() );
+  checksum = check.value();
+}
+
+static void parse_options( Parser& parser, size_t length, TCPSegment& segment )
+{
+  string options( length, 0 );
+  parser.string( options );
+  if ( parser.has_error() ) {
+    return;
+  }
+
+  size_t i = 0;
+  while ( i < options.size() ) {
+    const auto kind = static_cast<uint8_t>( options[i] );
+    if ( kind == OPTION_END ) {
+      break;
+    }
+    if ( kind == OPTION_NOP ) {
+      ++i;
+      continue;
+    }
+    if ( i + 1 >= options.size() ) {
+      parser.set_error();
+      return;
+    }
+    const auto option_length = static_cast<uint8_t>( options[i + 1] );
+    if ( option_length < 2 or i + option_length > options.size() ) {
+      parser.set_error();
+      return;
+    }
+
+    const string_view value = string_view { options }.substr( i + 2, option_length - 2 );
+    if ( kind == OPTION_WINDOW_SCALE and value.size() == 1 ) {
+      if ( segment.message.SYN ) { // anywhere else, RFC 7323 says to ignore it
+        segment.reply.window_scale = static_cast<uint8_t>( value[0] );
+        segment.message.window_scaling = true;
+      }
+    } else if ( kind == OPTION_SACK and value.size() % SACK_BLOCK_LENGTH == 0 ) {
+      for ( size_t n = 0; n < value.size(); n += SACK_BLOCK_LENGTH ) {
+        segment.reply.sack_blocks.emplace_back( Wrap32 { big_endian( value.substr( n, 4 ) ) },
+                                                Wrap32 { big_endian( value.substr( n + 4, 4 ) ) } );
+      }
+    } else if ( kind == OPTION_WINDOW_SCALE or kind == OPTION_SACK ) {
+      parser.set_error();
+      return;
+    }
+    i += option_length;
+  }
+}
+
+void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
+{
+  // the checksum covers the segment exactly as it was sent, options and all
+  auto input = parser.input();
+  InternetChecksum check { datagram_layer_pseudo_checksum };
+  while ( not input.empty() ) {
+    check.add( input.peek() );
+    input.remove_prefix( input.peek().size() );
+  }
+
+  uint32_t seqno {};
+  uint32_t ackno {};
+  uint8_t data_offset {};
+  uint8_t flags {};
+  uint16_t urgent_pointer {};
+  parser.integer( source_port );
+  parser.integer( destination_port );
+  parser.integer( seqno );
+  parser.integer( ackno );
+  parser.integer( data_offset );
+  parser.integer( flags );
+  parser.integer( reply.window_size );
+  parser.integer( checksum );
+  parser.integer( urgent_pointer );
+
+  const size_t length = static_cast<size_t>( data_offset >> 4 ) * 4;
+  if ( parser.has_error() or length < TCPConfig::TCP_HEADER_LENGTH or check.value() != 0 ) {
+    parser.set_error();
+    return;
+  }
+
+  message.seqno = Wrap32 { seqno };
+  message.SYN = flags & FLAG_SYN;
+  message.FIN = flags & FLAG_FIN;
+  RST = flags & FLAG_RST;
+  reply.ackno.reset();
+  if ( flags & FLAG_ACK ) {
+    reply.ackno = Wrap32 { ackno };
+  }
+  message.window_scaling = false;
+  reply.window_scale = 0;
+  reply.sack_blocks.clear();
+
+  parse_options( parser, length - TCPConfig::TCP_HEADER_LENGTH, *this );
+  parser.all_remaining( message.payload );
+}
+
+void TCPSegment::serialize( Serializer& serializer ) const
+{
+  const uint8_t flags = ( message.FIN ? FLAG_FIN : 0 ) | ( message.SYN ? FLAG_SYN : 0 ) | ( RST ? FLAG_RST : 0 )
+                        | ( reply.ackno.has_value() ? FLAG_ACK : 0 );
+
+  serializer.integer( source_port );
+  serializer.integer( destination_port );
+  serializer.integer( raw( message.seqno ) );
+  serializer.integer( reply.ackno.has_value() ? raw( *reply.ackno ) : 0 );
+  serializer.integer( static_cast<uint8_t>( header_length() / 4 << 4 ) );
+  serializer.integer( flags );
+  serializer.integer( reply.window_size );
+  serializer.integer( checksum );
+  serializer.integer( uint16_t {} ); // urgent pointer
+
+  if ( window_scale_sent( *this ) ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_WINDOW_SCALE );
+    serializer.integer( uint8_t { 3 } );
+    serializer.integer( reply.window_scale );
+  }
+
+  const size_t blocks = sack_blocks_sent( *this );
+  if ( blocks ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_SACK );
+    serializer.integer( static_cast<uint8_t>( 2 + blocks * SACK_BLOCK_LENGTH ) );
+    for ( size_t i = 0; i < blocks; ++i ) {
+      serializer.integer( raw( reply.sack_blocks[i].first ) );
+      serializer.integer( raw( reply.sack_blocks[i].second ) );
+    }
+  }
+
+  serializer.buffer( message.payload );
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "parser.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender_message.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * A TCP segment as it crosses the network (RFC 9293 3.1): one TCPSenderMessage and one TCPReceiverMessage under
+ * a single header, so one end of a connection can acknowledge the other's data in the same segment that carries
+ * its own. The ACK flag is set when the reply has an ackno.
+ *
+ * Two options are understood. Window scale (RFC 7323) goes only on a SYN that offers scaling, and carries
+ * reply.window_scale, the shift the sender of the SYN will apply to the windows it reports; on other segments it
+ * is neither sent nor read, so whoever keeps the connection must remember the shift. SACK (RFC 2018) carries
+ * reply.sack_blocks, as many as fit in the 40 bytes of options. Other options are skipped when parsing.
+ */
+struct TCPSegment
+{
+  static constexpr size_t MAX_OPTIONS_LENGTH = 40; // the data offset counts at most 15 words of header
+
+  /*
+   *   0                   1                   2                   3
+   *   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |          Source Port          |       Destination Port        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                        Sequence Number                        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                    Acknowledgment Number                      |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |  Data |       |C|E|U|A|P|R|S|F|                               |
+   *  | Offset| Rsrvd |W|C|R|C|S|S|Y|I|            Window             |
+   *  |       |       |R|E|G|K|H|T|N|N|                               |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |           Checksum            |         Urgent Pointer        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                    Options                    |    Padding    |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   */
+
+  uint16_t source_port {};
+  uint16_t destination_port {};
+  TCPSenderMessage message {}; // seqno, SYN, FIN and payload (and window scaling, offered on a SYN)
+  TCPReceiverMessage reply {}; // ackno, window and its scale, and SACK blocks
+  bool RST {};                 // the connection is being reset
+  uint16_t checksum {};
+
+  // Length of the header with its options, and of the whole segment
+  size_t header_length() const;
+  size_t serialized_length() const { return header_length() + message.payload.size(); }
+
+  // Set the checksum to the correct value, given the pseudo-header's contribution (IPv4Header::pseudo_checksum)
+  void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
+
+  // Parse a whole segment, and flag an error if it is malformed or its checksum is wrong
+  void parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum );
+
+  // Serialize the segment (does not recompute the checksum)
+  void serialize( Serializer& serializer ) const;
+};
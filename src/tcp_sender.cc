@@ -4,18 +4,25 @@
 #include "tcp_sender_message.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <bits/ranges_base.h>
 #include <cstddef>
 #include <cstdint>
 #include <random>
+#include <stdexcept>
 
 using namespace std;
 
 /* TCPSender constructor (uses a random ISN if none given) */
-TCPSender::TCPSender( uint64_t initial_RTO_ms, optional<Wrap32> fixed_isn )
-  : isn_( fixed_isn.value_or( Wrap32 { random_device()() } ) ), initial_RTO_ms_( initial_RTO_ms )
+TCPSender::TCPSender( uint64_t initial_RTO_ms, optional<Wrap32> fixed_isn, uint64_t mss )
+  : isn_( fixed_isn.value_or( Wrap32 { random_device()() } ) ), initial_RTO_ms_( initial_RTO_ms ), mss_( mss )
 {}
 
+uint64_t TCPSender::max_payload_size() const
+{
+  return mss_;
+}
+
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
   return bytes_in_flight_;
@@ -26,16 +33,179 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return consecutive_retransmissions_;
 }
 
+uint64_t TCPSender::sequence_numbers_retransmitted() const
+{
+  return retransmitted_seqnos_;
+}
+
+uint64_t TCPSender::sequence_numbers_sacked() const
+{
+  return sacked_seqnos_;
+}
+
+uint64_t TCPSender::current_RTO_ms() const
+{
+  return retransmission_timeout_;
+}
+
+optional<uint64_t> TCPSender::smoothed_RTT_ms() const
+{
+  return srtt_ms_;
+}
+
+uint64_t TCPSender::duplicate_acks() const
+{
+  return total_duplicate_acks_;
+}
+
+uint64_t TCPSender::fast_retransmits() const
+{
+  return fast_retransmits_;
+}
+
+uint64_t TCPSender::segments_saved() const
+{
+  return segments_saved_;
+}
+
+uint64_t TCPSender::pacing_rate() const
+{
+  if ( !pacing_ || configured_pacing_rate_ ) {
+    return configured_pacing_rate_;
+  }
+  if ( !srtt_ms_.has_value() ) {
+    return 0;
+  }
+
+  uint64_t window = window_size_ ? window_size_ : 1;
+  uint64_t gain_percent = 120;
+  if ( congestion_control_ ) {
+    window = min( window, congestion_control_->window() );
+    if ( congestion_control_->window() < congestion_control_->ssthresh() ) {
+      gain_percent = 200; // keep up with a window that doubles every round trip
+    }
+  }
+  return window * 1000 * gain_percent / 100 / max( *srtt_ms_, uint64_t { 1 } );
+}
+
+optional<uint64_t> TCPSender::congestion_window() const
+{
+  if ( !congestion_control_ ) {
+    return {};
+  }
+  return congestion_control_->window();
+}
+
+optional<uint64_t> TCPSender::slow_start_threshold() const
+{
+  if ( !congestion_control_ ) {
+    return {};
+  }
+  return congestion_control_->ssthresh();
+}
+
+void TCPSender::set_congestion_control( unique_ptr<CongestionControl> congestion_control )
+{
+  congestion_control_ = move( congestion_control );
+  fast_retransmit_ = true;
+}
+
+void TCPSender::enable_fast_retransmit()
+{
+  fast_retransmit_ = true;
+}
+
+void TCPSender::enable_window_scaling()
+{
+  window_scaling_ = true;
+}
+
+void TCPSender::enable_coalescing( uint64_t max_delay_ms )
+{
+  coalescing_ = true;
+  max_coalescing_delay_ms_ = max_delay_ms;
+}
+
+void TCPSender::flush()
+{
+  flush_ = true;
+}
+
+void TCPSender::enable_pacing( uint64_t bytes_per_second )
+{
+  pacing_ = true;
+  configured_pacing_rate_ = bytes_per_second;
+}
+
+void TCPSender::enable_adaptive_RTO( uint64_t min_RTO_ms, uint64_t max_RTO_ms )
+{
+  adaptive_RTO_ = true;
+  min_RTO_ms_ = min_RTO_ms;
+  max_RTO_ms_ = max_RTO_ms;
+}
+
+void TCPSender::update_RTT( uint64_t rtt_sample_ms )
+{
+  /**
+   * RFC 6298, section 2: the first sample sets SRTT = R and RTTVAR = R/2, later ones are smoothed with
+   * alpha = 1/8 and beta = 1/4. RTO = SRTT + max(G, 4 * RTTVAR) with a clock granularity G of 1 ms.
+   */
+  if ( !srtt_ms_.has_value() ) {
+    srtt_ms_ = rtt_sample_ms;
+    rttvar_ms_ = rtt_sample_ms / 2;
+  } else {
+    const uint64_t deviation = *srtt_ms_ > rtt_sample_ms ? *srtt_ms_ - rtt_sample_ms : rtt_sample_ms - *srtt_ms_;
+    rttvar_ms_ = ( 3 * rttvar_ms_ + deviation ) / 4;
+    srtt_ms_ = ( 7 * *srtt_ms_ + rtt_sample_ms ) / 8;
+  }
+  if ( adaptive_RTO_ ) {
+    retransmission_timeout_ = clamp( *srtt_ms_ + max( uint64_t { 1 }, 4 * rttvar_ms_ ), min_RTO_ms_, max_RTO_ms_ );
+  }
+}
+
+OutstandingSegment* TCPSender::next_to_send()
+{
+  while ( !_messages.empty() ) {
+    const auto it = find_outstanding( _messages.front() );
+    if ( it != _outstanding_messages.end() && it->seqno == _messages.front() ) {
+      return &*it;
+    }
+    _messages.pop(); // acknowledged before it could be sent
+  }
+  return nullptr;
+}
+
 optional<TCPSenderMessage> TCPSender::maybe_send()
 {
-  if ( _messages.empty() ) { // if no mesage we return
+  OutstandingSegment* segment = next_to_send();
+  if ( !segment ) { // if no mesage we return
     return {};
   }
 
-  TCPSenderMessage msg = _messages.front(); // we need to send a data segment
-  _messages.pop();
+  const uint64_t rate = pacing_rate();
+  if ( rate ) {
+    /**
+     * Each segment pushes the next release back by its transmission time at the paced rate. A sender that is
+     * at most one millisecond late (a coarse tick) keeps its schedule so it can catch up; an idle one starts
+     * a new schedule now.
+     */
+    const uint64_t now_us = now_ms() * 1000;
+    if ( now_us < next_release_us_ ) {
+      return {};
+    }
+    const uint64_t start_us = next_release_us_ + 1000 >= now_us ? next_release_us_ : now_us;
+    next_release_us_ = start_us + segment->msg.sequence_length() * 1000000 / rate;
+  }
 
-  return msg;
+  _messages.pop();
+  if ( !segment->retransmitted ) {
+    segment->sent_at_ms = now_ms(); // now, not when push() queued it, so waiting for the pacer isn't RTT
+  }
+  segment->sent = true;
+  if ( !retransmission_timer_ ) { // the timer covers what is on the wire, not what the pacer still holds
+    start_timer();
+  }
+  return segment->msg; // the only copy of a segment, which shares its payload with the scoreboard's
 }
 
 void TCPSender::push( Reader& outbound_stream )
@@ -44,21 +214,39 @@ void TCPSender::push( Reader& outbound_stream )
     return;
   }
 
-  uint64_t space = rcvno + ( window_size_ ? window_size_ : 1 )
-                   - nxt_seqno_;      // total size (rcvno + window_size) - next seqno, is the amount of space still
-                                      // available in the window size
+  const uint64_t stream_end = outbound_stream.bytes_popped() + outbound_stream.bytes_buffered();
+  const bool new_write = stream_end > stream_end_; // has the application written since the last push()?
+  stream_end_ = stream_end;
+  if ( flush_ ) {
+    flush_until_ = stream_end;
+    flush_ = false;
+  }
+
+  uint64_t window = window_size_ ? window_size_ : 1;
+  if ( congestion_control_ ) { // the network may take less than the receiver
+    window = min( window, congestion_control_->window() );
+  }
+  if ( rcvno + window <= nxt_seqno_ ) {
+    return;
+  }
+  uint64_t space = rcvno + window - nxt_seqno_; // total size (rcvno + window) - next seqno, is the amount of space
+                                                // still available in the window
   while ( space > 0 && !fin_sent_ ) { // while we have more space and we are not finished
+    if ( hold_small_segment( outbound_stream, space, new_write ) ) {
+      return;
+    }
+
     TCPSenderMessage msg;
     if ( !nxt_seqno_ ) { // if this is the first msg we want to send, it is SYN
       msg.SYN = true;
+      msg.window_scaling = window_scaling_;
       syn_sent_ = true;
       --space; // SYN occupies one byte
     }
 
     msg.seqno = Wrap32::wrap( nxt_seqno_, isn_ );
-    Buffer& buffer = msg.payload;
-    read( outbound_stream, min( space, TCPConfig::MAX_PAYLOAD_SIZE ), buffer );
-    space -= buffer.size();
+    msg.payload = outbound_stream.pop_buffer( min( space, mss_ ) ); // shares the stream's storage when it can
+    space -= msg.payload.size();
     if ( outbound_stream.is_finished() && space > 0 ) { // if it is finished
       msg.FIN = true;
       fin_sent_ = true;
@@ -69,14 +257,44 @@ void TCPSender::push( Reader& outbound_stream )
     if ( !len ) { // if no length, then there is no data need to be sent
       return;
     }
-    _messages.push( msg );    // else there are some remaning data
-    if ( !timer_.in_run() ) { // start timer if timer not start
-      timer_.start();
+    _messages.push( nxt_seqno_ );                                   // else there are some remaning data
+    _outstanding_messages.push_back( { nxt_seqno_, move( msg ) } ); // push remaining data (timed when sent)
+    nxt_seqno_ += len;                                              // reset for next sequence number
+    bytes_in_flight_ += len;                                        // we send more data has not been acknolwedge
+  }
+}
+
+bool TCPSender::hold_small_segment( Reader& outbound_stream, uint64_t space, bool new_write )
+{
+  /**
+   * Nagle's algorithm (RFC 896, RFC 1122 section 4.2.3.4): while anything is unacknowledged, a segment smaller
+   * than the MSS waits for more data or an ack, unless nothing more can follow (the stream is closed), the
+   * application flushed it, or it has waited the maximum coalescing delay.
+   *
+   * A non-coalescing sender sends a segment for each write, so every write that is held saves one, and every
+   * release that no write triggered costs one back.
+   */
+  const uint64_t buffered = outbound_stream.bytes_buffered();
+  const bool small = buffered > 0 && min( buffered, space ) < mss_;
+  const bool delay_expired = held_since_ms_.has_value() && now_ms() - *held_since_ms_ >= max_coalescing_delay_ms_;
+  if ( coalescing_ && small && bytes_in_flight_ > 0 && !delay_expired && !outbound_stream.writer().is_closed()
+       && outbound_stream.bytes_popped() >= flush_until_ ) {
+    if ( !held_since_ms_.has_value() ) {
+      held_since_ms_ = now_ms();
+    }
+    if ( new_write ) {
+      ++segments_saved_;
     }
-    _outstanding_messages.push( msg ); // push remaining data
-    nxt_seqno_ += len;                 // reset for next sequence number
-    bytes_in_flight_ += len;           // we send more data has not been acknolwedge
+    return true;
   }
+
+  if ( held_since_ms_.has_value() && buffered > 0 ) {
+    held_since_ms_.reset();
+    if ( !new_write && segments_saved_ > 0 ) {
+      --segments_saved_;
+    }
+  }
+  return false;
 }
 
 TCPSenderMessage TCPSender::send_empty_message() const
@@ -91,6 +309,8 @@ TCPSenderMessage TCPSender::send_empty_message() const
 
 void TCPSender::receive( const TCPReceiverMessage& msg )
 {
+  const uint64_t previous_rcvno = rcvno;
+  const uint64_t previous_window_size = window_size_;
 
   // if there is an acknolowdge flag means a new message
   if ( msg.ackno ) {
@@ -100,53 +320,258 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
   if ( rcvno > nxt_seqno_ ) { // impossible to receive a future data.
     return;
   }
-  window_size_ = msg.window_size; // update window size
+  // update window size, scaled only if our SYN offered window scaling
+  const uint8_t window_scale = window_scaling_ ? min( msg.window_scale, TCPConfig::MAX_WINDOW_SCALE ) : 0;
+  window_size_ = uint64_t { msg.window_size } << window_scale;
 
-  bool new_check_ = false; // flag for "do we need to reset the timer ?"
+  bool new_check_ = false;          // flag for "do we need to reset the timer ?"
+  uint64_t acked = 0;               // payload bytes newly acknowledged (the SYN and FIN don't grow cwnd)
+  optional<uint64_t> rtt_sample {}; // from the newest acked segment that was sent only once
+  bool acks_retransmission = false; // then the ack waited for the resent segment, and times nothing (Karn's rule)
   while (
     !_outstanding_messages.empty() ) { // after receiving data, check if we need to update our oustanding queue.
-    TCPSenderMessage s_msg = _outstanding_messages.front();
-    uint64_t len = s_msg.sequence_length();
-    uint64_t seqno
-      = s_msg.seqno.unwrap( isn_, nxt_seqno_ ); // unwrap it provide zero point and closest to the next_seqno_;
-    if ( seqno + len > rcvno ) {                // if we haven't acknowledge this data, break;
+    const OutstandingSegment& segment = _outstanding_messages.front();
+    uint64_t len = segment.msg.sequence_length();
+    if ( segment.seqno + len > rcvno ) { // if we haven't acknowledge this data, break;
       break;
     }
-    _outstanding_messages.pop(); // then this is an outstanding data we now received
-    bytes_in_flight_ -= len;     // received len bit minus it
+    if ( segment.sacked ) {
+      sacked_seqnos_ -= len;
+    }
+    if ( segment.retransmitted ) {
+      acks_retransmission = true;
+    } else {
+      rtt_sample = now_ms() - segment.sent_at_ms;
+    }
+    acked += segment.msg.payload.size();
+    _outstanding_messages.pop_front(); // then this is an outstanding data we now received
+    bytes_in_flight_ -= len;           // received len bit minus it
     new_check_ = true;
   }
-  if ( new_check_ ) {                          // reset timer
-    retransmission_timeout_ = initial_RTO_ms_; // back to intiial zero
-    if ( !_outstanding_messages.empty() ) {    // if it is not empty, start the timer
-      timer_.start();
+  mark_sacked( msg );
+
+  // a duplicate ack acknowledges nothing new and changes nothing else while data is outstanding
+  if ( !new_check_ && msg.ackno.has_value() && rcvno == previous_rcvno && window_size_ == previous_window_size
+       && !_outstanding_messages.empty() ) {
+    on_duplicate_ack();
+  } else if ( new_check_ ) {
+    duplicate_acks_ = 0;
+  }
+
+  if ( rtt_sample.has_value() && !acks_retransmission ) {
+    update_RTT( *rtt_sample );
+  }
+  if ( new_check_ && congestion_control_ ) {
+    if ( !fast_recovery_ ) {
+      congestion_control_->on_ack( acked, now_ms(), srtt_ms_ );
+    } else if ( rcvno >= *recovery_point_ ) {
+      congestion_control_->on_exit_recovery();
     } else {
-      timer_.stop(); // stop the timer since no dat is outstanding
+      congestion_control_->on_partial_ack( acked );
+    }
+  }
+
+  if ( recovery_point_.has_value() && rcvno >= *recovery_point_ ) { // everything sent before the loss is acked
+    recovery_point_.reset();
+    fast_recovery_ = false;
+  } else if ( recovery_point_.has_value() && new_check_ ) { // partial ack: fill the next hole without an RTO
+    retransmit_next_hole();
+  }
+
+  if ( new_check_ ) { // reset timer
+    if ( !adaptive_RTO_ ) {
+      retransmission_timeout_ = initial_RTO_ms_; // back to intiial zero
+    } // without a valid sample (Karn's rule), the adaptive RTO stays backed off
+    if ( !_outstanding_messages.empty() && _outstanding_messages.front().sent ) { // data is on the wire
+      start_timer();
+    } else {
+      stop_timer(); // stop the timer since no dat is outstanding, or the pacer hasn't sent it yet
     }
     consecutive_retransmissions_
       = 0; // we received an outstanding data segment so it is not hopeless connection, reset zero.
   }
 }
 
+deque<OutstandingSegment>::iterator TCPSender::find_outstanding( uint64_t seqno )
+{
+  return lower_bound( _outstanding_messages.begin(),
+                      _outstanding_messages.end(),
+                      seqno,
+                      []( const OutstandingSegment& segment, uint64_t value ) { return segment.seqno < value; } );
+}
+
+void TCPSender::mark_sacked( const TCPReceiverMessage& msg )
+{
+  /**
+   * Mark every outstanding segment that lies entirely inside a SACK block, so tick() can skip it.
+   * The scoreboard is ordered by seqno, so each block is a binary search away.
+   */
+  for ( const auto& [left, right] : msg.sack_blocks ) {
+    const uint64_t first = left.unwrap( isn_, nxt_seqno_ );
+    const uint64_t last = right.unwrap( isn_, nxt_seqno_ );
+    for ( auto it = find_outstanding( first );
+          it != _outstanding_messages.end() && it->seqno + it->msg.sequence_length() <= last;
+          ++it ) {
+      if ( !it->sacked ) {
+        it->sacked = true;
+        sacked_seqnos_ += it->msg.sequence_length();
+      }
+    }
+  }
+}
+
+void TCPSender::on_duplicate_ack()
+{
+  /**
+   * Three duplicates mean segments after a hole are arriving: resend the hole now instead of waiting for the
+   * RTO (RFC 5681, section 3.2). Duplicates for data sent before an RTO don't start another recovery.
+   */
+  ++duplicate_acks_;
+  ++total_duplicate_acks_;
+  if ( !fast_retransmit_ ) {
+    return;
+  }
+  if ( fast_recovery_ ) {
+    if ( congestion_control_ ) {
+      congestion_control_->on_duplicate_ack();
+    }
+    return;
+  }
+  if ( duplicate_acks_ != 3 || recovery_point_.has_value() ) {
+    return;
+  }
+
+  if ( congestion_control_ ) {
+    congestion_control_->on_enter_recovery( bytes_in_flight_, now_ms() );
+  }
+  fast_recovery_ = true;
+  recovery_point_ = nxt_seqno_;
+  ++fast_retransmits_;
+  retransmit( oldest_unsacked() );
+}
+
+void TCPSender::retransmit( OutstandingSegment& segment )
+{
+  _messages.push( segment.seqno );
+  segment.retransmitted = true;
+  retransmitted_seqnos_ += segment.msg.sequence_length();
+  retx_high_ = segment.seqno + segment.msg.sequence_length();
+}
+
+OutstandingSegment& TCPSender::oldest_unsacked()
+{
+  auto it = find_if( _outstanding_messages.begin(),
+                     _outstanding_messages.end(),
+                     []( const OutstandingSegment& segment ) { return !segment.sacked; } );
+  if ( it == _outstanding_messages.end() ) { // the receiver claims to hold everything: don't trust it
+    it = _outstanding_messages.begin();
+  }
+  return *it;
+}
+
+void TCPSender::retransmit_next_hole()
+{
+  /**
+   * Only segments below the highest SACKed one are known to be missing, and the ones below `retx_high_`
+   * have already been resent in this recovery. Without SACK, NewReno fast recovery takes a partial ack to
+   * mean the segment right after it was lost too, and so does a congestion-controlled sender after an RTO,
+   * which is back in slow start anyway: otherwise each further loss from the window the timeout hit costs
+   * another, doubled, RTO.
+   */
+  const auto highest_sacked = find_if( _outstanding_messages.rbegin(),
+                                       _outstanding_messages.rend(),
+                                       []( const OutstandingSegment& segment ) { return segment.sacked; } );
+  if ( highest_sacked == _outstanding_messages.rend() ) {
+    if ( ( fast_recovery_ || congestion_control_ ) && !_outstanding_messages.empty()
+         && _outstanding_messages.front().seqno >= retx_high_ ) {
+      retransmit( _outstanding_messages.front() );
+    }
+    return;
+  }
+
+  for ( auto& segment : _outstanding_messages ) {
+    if ( segment.seqno >= highest_sacked->seqno ) {
+      break;
+    }
+    if ( !segment.sacked && segment.seqno >= retx_high_ ) {
+      retransmit( segment );
+      return;
+    }
+  }
+}
+
 void TCPSender::tick( const size_t ms_since_last_tick )
 {
+  if ( !timers_ || own_timers_ ) { // a shared wheel is advanced by its owner
+    timers().advance( ms_since_last_tick );
+  }
+}
+
+TimerWheel& TCPSender::timers()
+{
+  if ( !timers_ ) {
+    own_timers_ = make_unique<TimerWheel>();
+    timers_ = own_timers_.get();
+  }
+  return *timers_;
+}
+
+void TCPSender::use_timer_wheel( TimerWheel& wheel )
+{
+  if ( syn_sent_ ) {
+    throw runtime_error( "TCPSender: use_timer_wheel() after the first push()" );
+  }
+  timers_ = &wheel;
+  own_timers_.reset();
+}
+
+void TCPSender::start_timer()
+{
+  if ( retransmission_timer_ && timers().reschedule( *retransmission_timer_, retransmission_timeout_ ) ) {
+    return;
+  }
+  retransmission_timer_ = timers().schedule( retransmission_timeout_,
+                                             on_timer( []( TCPSender& sender ) { sender.on_timer_expired(); } ) );
+}
+
+void TCPSender::stop_timer()
+{
+  if ( retransmission_timer_ ) {
+    timers().cancel( *retransmission_timer_ );
+    retransmission_timer_.reset();
+  }
+}
+
+void TCPSender::on_timer_expired()
+{
+  retransmission_timer_.reset();
+
   /**
    * We want to resend if the timer goes off and there are outstanding segments.
    *
    * After timer expired
-   * 1. push the earliest segment to the message queue
+   * 1. push the earliest segment the receiver hasn't SACKed to the message queue
    * 2. double timout and increment consecutive retrransmission if window size is nonzero
    * 3. reset the timer
    */
-  if ( _outstanding_messages.empty() || !timer_.expired( ms_since_last_tick, retransmission_timeout_ ) ) {
+  if ( _outstanding_messages.empty() ) {
     return;
   }
 
-  _messages.push( _outstanding_messages.front() );
+  retransmit( oldest_unsacked() );
+  recovery_point_ = nxt_seqno_;
+  if ( congestion_control_ ) {
+    congestion_control_->on_timeout( bytes_in_flight_, now_ms() );
+  }
+  fast_recovery_ = false;
+  duplicate_acks_ = 0;
 
   if ( window_size_ > 0 ) {
     retransmission_timeout_ <<= 1;
+    if ( adaptive_RTO_ ) { // backed off, but no further than the maximum (RFC 6298, section 5.5)
+      retransmission_timeout_ = min( retransmission_timeout_, max_RTO_ms_ );
+    }
   }
   consecutive_retransmissions_++;
-  timer_.start();
+  start_timer();
 }
\ No newline at end of file
@@ -1,57 +1,144 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
+#include "timer_wheel.hh"
 #include <cstdint>
+#include <deque>
+#include <memory>
 
-class Timer
+// A segment that has been sent but not yet acknowledged
+struct OutstandingSegment
 {
-private:
-  uint64_t ticks_ = 0;
-  bool running = false;
-
-public:
-  bool expired( uint64_t ms_since_last_tick, uint64_t time_out_ )
-  {
-    ticks_ += ms_since_last_tick;
-    return running && ( ticks_ >= time_out_ );
-  }
-  uint64_t tick_now() { return ticks_; }
-  bool in_run() { return running; }
-  void start()
-  {
-    ticks_ = 0;
-    running = true;
-  }
-  void stop() { running = false; }
+  uint64_t seqno {};            // absolute sequence number of the segment's first sequence number
+  TCPSenderMessage msg {};      // the segment as it was sent
+  bool sacked { false };        // the receiver reported holding it in a SACK block
+  bool sent { false };          // handed out by maybe_send(), rather than still waiting in the queue
+  uint64_t sent_at_ms {};       // when maybe_send() first handed it out, for RTT samples
+  bool retransmitted { false }; // sent more than once, so its ack gives no RTT sample (Karn's rule)
 };
 
-class TCPSender
+class TCPSender : public TimerOwner<TCPSender>
 {
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
+  uint64_t mss_;
   uint64_t consecutive_retransmissions_ = 0;
   uint64_t rcvno = 0;
   uint64_t nxt_seqno_ = 0;
   uint64_t window_size_ = 1;
+  bool window_scaling_ = false; // offered on the SYN, so the receiver may scale its windows
   uint64_t retransmission_timeout_ = initial_RTO_ms_;
   uint64_t bytes_in_flight_ = 0;
   bool syn_sent_ = false;
   bool fin_sent_ = false;
-  Timer timer_ {};
-  std::queue<TCPSenderMessage> _messages {};
-  std::queue<TCPSenderMessage> _outstanding_messages {};
+  // The retransmission timer runs on the sender's own wheel, which tick() advances, or on a shared one. Its
+  // callback finds the sender through TimerOwner, so the sender can be moved while the timer is running. The own
+  // wheel is only made on the first tick() or timer, so a sender given a shared one never allocates it.
+  std::unique_ptr<TimerWheel> own_timers_ {};
+  TimerWheel* timers_ {};
+  std::optional<TimerWheel::TimerId> retransmission_timer_ {};
+  std::queue<uint64_t> _messages {}; // segments to send, by the seqno of their record in the scoreboard
+  std::deque<OutstandingSegment> _outstanding_messages {}; // scoreboard, ordered by absolute seqno
+  uint64_t retransmitted_seqnos_ = 0;
+  uint64_t sacked_seqnos_ = 0;
+  std::optional<uint64_t> recovery_point_ {}; // nxt_seqno_ when the timer last expired, until it is acked
+  uint64_t retx_high_ = 0;                     // end of the highest segment retransmitted during recovery
+
+  // RTT estimation and adaptive RTO (RFC 6298), when enabled
+  bool adaptive_RTO_ = false;
+  uint64_t min_RTO_ms_ = 0;
+  uint64_t max_RTO_ms_ = 0;
+  std::optional<uint64_t> srtt_ms_ {};
+  uint64_t rttvar_ms_ = 0;
+
+  // fast retransmit, and congestion control when a controller is set
+  std::unique_ptr<CongestionControl> congestion_control_ {};
+  bool fast_retransmit_ = false;
+  uint64_t duplicate_acks_ = 0; // acks in a row that acknowledged nothing new
+  bool fast_recovery_ = false;  // entered on the third duplicate ack, left when recovery_point_ is acked
+  uint64_t total_duplicate_acks_ = 0;
+  uint64_t fast_retransmits_ = 0;
+
+  // pacing, when enabled
+  bool pacing_ = false;
+  uint64_t configured_pacing_rate_ = 0; // bytes per second, or 0 to derive it from the window and SRTT
+  uint64_t next_release_us_ = 0;        // when maybe_send() may hand out the next segment
+
+  // coalescing of small writes (Nagle), when enabled
+  bool coalescing_ = false;
+  uint64_t max_coalescing_delay_ms_ = 0;
+  std::optional<uint64_t> held_since_ms_ {}; // when push() started holding back a small segment
+  bool flush_ = false;
+  uint64_t flush_until_ = 0; // stream index below which nothing is held back
+  uint64_t stream_end_ = 0;  // bytes the application had written at the last push()
+  uint64_t segments_saved_ = 0;
+
+  uint64_t now_ms() const { return timers_ ? timers_->now() : 0; }
+  TimerWheel& timers();
+  void start_timer();
+  void stop_timer();
+  void on_timer_expired();
+
+  std::deque<OutstandingSegment>::iterator find_outstanding( uint64_t seqno ); // first at or after `seqno`
+  OutstandingSegment* next_to_send();
+  void mark_sacked( const TCPReceiverMessage& msg );
+  void retransmit( OutstandingSegment& segment );
+  OutstandingSegment& oldest_unsacked();
+  void retransmit_next_hole();
+  void update_RTT( uint64_t rtt_sample_ms );
+  void on_duplicate_ack();
+  bool hold_small_segment( Reader& outbound_stream, uint64_t space, bool new_write );
 
 public:
-  /* Construct TCP sender with given default Retransmission Timeout and
-   * possible ISN */
-  TCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn );
+  /* Construct TCP sender with given default Retransmission Timeout,
+   * possible ISN, and largest payload per segment (see TCPConfig::mss_for_mtu) */
+  TCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn, uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE );
+
+  /* Move-only: the retransmission timer belongs to one sender, and moves with it */
+  TCPSender( const TCPSender& ) = delete;
+  TCPSender& operator=( const TCPSender& ) = delete;
+  TCPSender( TCPSender&& ) = default;
+  TCPSender& operator=( TCPSender&& ) = default;
+  ~TCPSender() = default;
+
+  /* Derive the RTO from measured round-trip times (RFC 6298) instead of resetting it to the initial value
+   * on every ack. The RTO is clamped to [min_RTO_ms, max_RTO_ms]. */
+  void enable_adaptive_RTO( uint64_t min_RTO_ms = 1000, uint64_t max_RTO_ms = 60000 );
+
+  /* Resend the oldest unacknowledged segment on the third duplicate ack instead of waiting for the RTO, and
+   * treat later partial acks as losses of the next segment until recovery ends (RFC 5681/6582). */
+  void enable_fast_retransmit();
+
+  /* Limit the sequence numbers in flight to min(cwnd, receiver's window), and let the controller react to
+   * fast retransmits (this enables them) and timeouts. Without one only the receiver's window counts. */
+  void set_congestion_control( std::unique_ptr<CongestionControl> congestion_control );
+
+  /* Offer window scaling (RFC 7323) on the SYN, and apply the receiver's shift count to the windows it reports.
+   * Must be called before the first push(). */
+  void enable_window_scaling();
+
+  /* Coalesce small writes (Nagle's algorithm): while data is unacknowledged, hold back a segment smaller than
+   * the MSS until an ack arrives, the stream closes, flush() is called, or it has been held `max_delay_ms`.
+   * The delay is measured with tick(), and the held bytes leave on the next push() after it has passed, which
+   * a TCPPeer makes on every tick. */
+  void enable_coalescing( uint64_t max_delay_ms = 200 );
+
+  /* Let the next push() send everything written so far, however small */
+  void flush();
+
+  /* Space the segments maybe_send() hands out so they leave at `bytes_per_second` instead of in one burst.
+   * With 0, the rate follows the window: min(cwnd, rwnd) per SRTT, doubled in slow start and 1.2x otherwise.
+   * Nothing is paced until there is a rate. */
+  void enable_pacing( uint64_t bytes_per_second = 0 );
 
   /* Push bytes from the outbound stream */
   void push( Reader& outbound_stream );
 
-  /* Send a TCPSenderMessage if needed (or empty optional otherwise) */
+  /* Send a TCPSenderMessage if needed (or empty optional otherwise), and if pacing allows it */
   std::optional<TCPSenderMessage> maybe_send();
 
   /* Generate an empty TCPSenderMessage */
@@ -64,7 +151,22 @@ public:
    * tick() method was called. */
   void tick( uint64_t ms_since_last_tick );
 
+  /* Run the retransmission timer on a wheel shared with other connections. Call it before the first push();
+   * from then on, time comes from the wheel, so advance the wheel instead of calling tick(). */
+  void use_timer_wheel( TimerWheel& wheel );
+
   /* Accessors for use in testing */
-  uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
-  uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  uint64_t max_payload_size() const;                    // What is the MSS?
+  uint64_t sequence_numbers_in_flight() const;          // How many sequence numbers are outstanding?
+  uint64_t consecutive_retransmissions() const;         // How many consecutive *re*transmissions have happened?
+  uint64_t sequence_numbers_retransmitted() const;      // How many sequence numbers have been sent again in total?
+  uint64_t sequence_numbers_sacked() const;             // How many outstanding ones does the receiver already hold?
+  uint64_t current_RTO_ms() const;                      // What is the retransmission timeout right now?
+  std::optional<uint64_t> smoothed_RTT_ms() const;      // What is the smoothed RTT (SRTT), if it has been measured?
+  uint64_t duplicate_acks() const;                      // How many acks have acknowledged nothing new?
+  uint64_t fast_retransmits() const;                    // How often did three duplicates trigger a resend?
+  uint64_t segments_saved() const;                      // How many segments has coalescing avoided?
+  uint64_t pacing_rate() const;                         // How many bytes per second may leave (0 if unpaced)?
+  std::optional<uint64_t> congestion_window() const;    // What is cwnd, if there is congestion control?
+  std::optional<uint64_t> slow_start_threshold() const; // What is ssthresh, if there is congestion control?
 };
\ No newline at end of file
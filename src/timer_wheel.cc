@@ -0,0 +1,186 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+using namespace std;
+
+TimerWheel::TimerId TimerWheel::schedule( uint64_t delay_ms, Callback callback )
+{
+  uint32_t index {};
+  if ( free_nodes_.empty() ) {
+    index = static_cast<uint32_t>( nodes_.size() );
+    nodes_.emplace_back();
+  } else {
+    index = free_nodes_.back();
+    free_nodes_.pop_back();
+  }
+
+  Node& node = nodes_[index];
+  node.deadline = now_ + delay_ms;
+  node.callback = std::move( callback );
+  place( index );
+  ++size_;
+  return ( TimerId { node.generation } << 32 ) | index;
+}
+
+uint32_t TimerWheel::find( TimerId id ) const
+{
+  const auto index = static_cast<uint32_t>( id );
+  if ( index >= nodes_.size() || nodes_[index].generation != id >> 32 || nodes_[index].list == NONE ) {
+    return NONE;
+  }
+  return index;
+}
+
+bool TimerWheel::reschedule( TimerId id, uint64_t delay_ms )
+{
+  const uint32_t index = find( id );
+  if ( index == NONE ) {
+    return false;
+  }
+
+  // a later deadline can wait in the timer's slot, which comes due no later than the old one did
+  Node& node = nodes_[index];
+  const uint64_t deadline = now_ + delay_ms;
+  const bool refile = deadline < node.deadline || node.list == DUE;
+  node.deadline = deadline;
+  if ( refile ) {
+    unlink( index );
+    place( index );
+  }
+  return true;
+}
+
+bool TimerWheel::cancel( TimerId id )
+{
+  const uint32_t index = find( id );
+  if ( index == NONE ) {
+    return false;
+  }
+
+  unlink( index );
+  Node& node = nodes_[index];
+  node.callback = nullptr;
+  ++node.generation;
+  free_nodes_.push_back( index );
+  --size_;
+  return true;
+}
+
+void TimerWheel::place( uint32_t index )
+{
+  const uint64_t deadline = nodes_[index].deadline;
+  if ( deadline <= now_ ) {
+    link( index, DUE );
+    return;
+  }
+
+  // the highest digit in which the deadline differs from now picks the level, and its value the slot
+  const auto level = static_cast<unsigned>( bit_width( deadline ^ now_ ) - 1 ) / SLOT_BITS;
+  if ( level >= LEVELS ) {
+    link( index, OVERFLOW );
+    return;
+  }
+  const uint64_t slot = ( deadline >> ( level * SLOT_BITS ) ) & ( SLOTS - 1 );
+  link( index, static_cast<uint32_t>( level * SLOTS + slot ) );
+  occupied_[level] |= uint64_t { 1 } << slot;
+}
+
+void TimerWheel::link( uint32_t index, uint32_t list )
+{
+  Node& node = nodes_[index];
+  List& l = lists_[list];
+  node.list = list;
+  node.prev = l.tail;
+  node.next = NONE;
+  if ( l.tail == NONE ) {
+    l.head = index;
+  } else {
+    nodes_[l.tail].next = index;
+  }
+  l.tail = index;
+}
+
+void TimerWheel::unlink( uint32_t index )
+{
+  Node& node = nodes_[index];
+  List& l = lists_[node.list];
+  ( node.prev == NONE ? l.head : nodes_[node.prev].next ) = node.next;
+  ( node.next == NONE ? l.tail : nodes_[node.next].prev ) = node.prev;
+  if ( l.head == NONE && node.list < OVERFLOW ) {
+    occupied_[node.list / SLOTS] &= ~( uint64_t { 1 } << ( node.list % SLOTS ) );
+  }
+  node.list = NONE;
+}
+
+void TimerWheel::move_list( uint32_t list )
+{
+  // detach the whole list first: a timer in the overflow may belong there again
+  uint32_t index = lists_[list].head;
+  lists_[list] = {};
+  if ( list < OVERFLOW ) {
+    occupied_[list / SLOTS] &= ~( uint64_t { 1 } << ( list % SLOTS ) );
+  }
+  while ( index != NONE ) {
+    const uint32_t next = nodes_[index].next;
+    place( index );
+    ++timers_moved_;
+    index = next;
+  }
+}
+
+void TimerWheel::advance( uint64_t ms )
+{
+  const uint64_t target = now_ + ms;
+
+  // Step from one occupied slot to the next until the target, collecting the expired timers
+  while ( true ) {
+    // The lowest level with an occupied slot ahead of now holds the earliest one: the slots of a level lie
+    // within the current slot of the level above.
+    unsigned level = 0;
+    uint64_t slot = 0;
+    for ( ; level < LEVELS; ++level ) {
+      const uint64_t position = ( now_ >> ( level * SLOT_BITS ) ) & ( SLOTS - 1 );
+      const uint64_t ahead = position + 1 < SLOTS ? occupied_[level] & ( ~uint64_t { 0 } << ( position + 1 ) ) : 0;
+      if ( ahead != 0 ) {
+        slot = static_cast<uint64_t>( countr_zero( ahead ) );
+        break;
+      }
+    }
+
+    // the slot lies in the current span of the level above, the overflow beyond the current span of the top level
+    const unsigned span_bits = min( level + 1, LEVELS ) * SLOT_BITS;
+    const uint64_t span_start = now_ >> span_bits << span_bits;
+    uint64_t next {};
+    if ( level < LEVELS ) {
+      next = span_start + ( slot << ( level * SLOT_BITS ) );
+    } else if ( lists_[OVERFLOW].head != NONE ) {
+      next = span_start + ( uint64_t { 1 } << span_bits ); // when the overflow may come within reach
+    } else {
+      break;
+    }
+    if ( next > target ) {
+      break;
+    }
+
+    now_ = next;
+    move_list( level < LEVELS ? static_cast<uint32_t>( level * SLOTS + slot ) : OVERFLOW );
+  }
+  now_ = target;
+
+  // Run the expired timers, including any that their callbacks make due at once
+  while ( lists_[DUE].head != NONE ) {
+    const uint32_t index = lists_[DUE].head;
+    unlink( index );
+    Node& node = nodes_[index];
+    Callback callback = std::move( node.callback );
+    node.callback = nullptr;
+    ++node.generation;
+    free_nodes_.push_back( index );
+    --size_;
+    ++timers_fired_;
+    callback();
+  }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/*
+ * A hierarchical hashed timing wheel (Varghese and Lauck), meant to be shared by many objects: each schedules
+ * its own timers, and whoever owns the clock calls advance() to run the callbacks of those that expire.
+ * Scheduling, rescheduling and cancelling take constant time. Advancing costs a constant per expiring timer, plus
+ * a move down a level for timers whose slot comes due; it does not depend on how many timers are pending.
+ *
+ * Level 0 has one slot per millisecond of the current 64 ms, level 1 one per 64 ms of the current 4096 ms, and
+ * so on for four levels (about 4.7 hours). Timers further out wait in an overflow list until the clock gets
+ * there.
+ */
+class TimerWheel
+{
+public:
+  using TimerId = uint64_t;
+  using Callback = std::function<void()>;
+
+  /* Run `callback` once `delay_ms` milliseconds have passed */
+  TimerId schedule( uint64_t delay_ms, Callback callback );
+
+  /*
+   * Move a timer that hasn't fired yet to `delay_ms` milliseconds from now, keeping its callback. Returns whether
+   * there was one. Putting a timer off, as a retransmission timer is on every ack, only changes its deadline: it
+   * stays in its slot, and is placed again by the new deadline when that slot comes due.
+   */
+  bool reschedule( TimerId id, uint64_t delay_ms );
+
+  /* Forget a timer that hasn't fired yet. Returns whether there was one. */
+  bool cancel( TimerId id );
+
+  /*
+   * Time has passed: run the callbacks of the timers that expired, in order of deadline. Like a coarse tick,
+   * they all run at the end of the interval, which is what now() reports and what the timers they schedule
+   * count from.
+   */
+  void advance( uint64_t ms );
+
+  uint64_t now() const { return now_; }          // milliseconds advanced since construction
+  size_t pending_timers() const { return size_; } // scheduled and not yet fired or cancelled
+  uint64_t timers_fired() const { return timers_fired_; }
+  uint64_t timers_moved() const { return timers_moved_; } // placed again when their slot came due
+
+private:
+  static constexpr unsigned SLOT_BITS = 6;
+  static constexpr uint64_t SLOTS = uint64_t { 1 } << SLOT_BITS;
+  static constexpr unsigned LEVELS = 4;
+  static constexpr uint32_t OVERFLOW = LEVELS * SLOTS; // deadlines beyond the top level's span
+  static constexpr uint32_t DUE = OVERFLOW + 1;        // expired, waiting for their callbacks to run
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  // Timers live in `nodes_` and are linked into one list each: a slot, the overflow or the due list
+  struct Node
+  {
+    uint64_t deadline {};
+    Callback callback {};
+    uint32_t generation {}; // tells a TimerId from one for an earlier timer in the same node
+    uint32_t list { NONE }; // NONE while the node is free
+    uint32_t prev { NONE };
+    uint32_t next { NONE };
+  };
+
+  struct List
+  {
+    uint32_t head { NONE };
+    uint32_t tail { NONE };
+  };
+
+  std::vector<Node> nodes_ {};
+  std::vector<uint32_t> free_nodes_ {};
+  std::array<List, DUE + 1> lists_ {};
+  std::array<uint64_t, LEVELS> occupied_ {}; // bit `s` of occupied_[l] is set if slot `s` of level `l` has timers
+  uint64_t now_ { 0 };
+  size_t size_ { 0 };
+  uint64_t timers_fired_ { 0 };
+  uint64_t timers_moved_ { 0 };
+
+  uint32_t find( TimerId id ) const; // the node of a timer that hasn't fired yet, or NONE
+  void place( uint32_t index );      // link a node into the list its deadline calls for, relative to now_
+  void link( uint32_t index, uint32_t list );
+  void unlink( uint32_t index );
+  void move_list( uint32_t list ); // unlink every node of a list and place it again
+};
+
+/*
+ * A base for objects that schedule timers and can be moved: `class C : public TimerOwner<C>`. A callback made by
+ * on_timer() reaches the object through a handle that follows it when it moves, and leads nowhere once it is
+ * destroyed, so a timer it left on a shared wheel fires harmlessly.
+ */
+template<class Owner>
+class TimerOwner
+{
+  std::shared_ptr<TimerOwner*> self_ {}; // where the object is now; made by the first on_timer()
+
+protected:
+  TimerOwner() = default;
+  TimerOwner( const TimerOwner& ) = delete;
+  TimerOwner& operator=( const TimerOwner& ) = delete;
+  TimerOwner( TimerOwner&& other ) noexcept : self_( std::move( other.self_ ) ) { follow(); }
+  TimerOwner& operator=( TimerOwner&& other ) noexcept
+  {
+    if ( this != &other ) {
+      abandon(); // the timers of the object being replaced
+      self_ = std::move( other.self_ );
+      follow();
+    }
+    return *this;
+  }
+  ~TimerOwner() { abandon(); }
+
+  // A TimerWheel callback that runs `action` on the object, wherever it is by then
+  template<class Action>
+  TimerWheel::Callback on_timer( Action action )
+  {
+    if ( !self_ ) {
+      self_ = std::make_shared<TimerOwner*>( this );
+    }
+    return [self = self_, action = std::move( action )] {
+      if ( *self ) {
+        action( static_cast<Owner&>( **self ) );
+      }
+    };
+  }
+
+private:
+  void follow()
+  {
+    if ( self_ ) {
+      *self_ = this;
+    }
+  }
+  void abandon()
+  {
+    if ( self_ ) {
+      *self_ = nullptr;
+    }
+  }
+};
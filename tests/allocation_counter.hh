@@ -0,0 +1,30 @@
+#pragma once
+
+// Replaces the global operator new and delete to count every allocation the program makes, so a speed test can
+// report how many its work costs. Include it in exactly one file of a test program.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+inline uint64_t allocations = 0;
+
+void* operator new( size_t size )
+{
+  ++allocations;
+  if ( void* ptr = malloc( size ? size : 1 ) ) { // NOLINT(*-no-malloc, *-owning-memory)
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc, *-owning-memory)
+}
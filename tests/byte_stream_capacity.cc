@@ -97,6 +97,46 @@ int main()
       test.execute( BytesBuffered { 1 } );
     }
 
+    {
+      ByteStreamTestHarness test { "growing keeps wrapped bytes in order", 4 };
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "def" } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( SetCapacity { 8 } );
+      test.execute( Capacity { 8 } );
+      test.execute( AvailableCapacity { 4 } );
+      test.execute( Peek { "cdef" } );
+      test.execute( Push { "ghijk" } );
+      test.execute( BytesPushed { 10 } );
+      test.execute( Peek { "cdefghij" } );
+      test.execute( Pop { 6 } );
+      test.execute( Push { "xyz" } );
+      test.execute( Peek { "ijxyz" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "shrinking stops at the bytes buffered", 10 };
+      test.execute( Push { "abcdefgh" } );
+      test.execute( Pop { 7 } );
+      test.execute( PushMoved { "ij" } );
+      test.execute( SetCapacity { 2 } );
+      test.execute( Capacity { 3 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Peek { "hij" } );
+      test.execute( Pop { 3 } );
+      test.execute( Push { "klmn" } );
+      test.execute( Peek { "klm" } );
+      test.execute( SetCapacity { 0 } );
+      test.execute( Capacity { 3 } );
+      test.execute( Pop { 3 } );
+      test.execute( SetCapacity { 1 } );
+      test.execute( Capacity { 1 } );
+      test.execute( Push { "op" } );
+      test.execute( Peek { "o" } );
+      test.execute( BytesPushed { 14 } );
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
@@ -0,0 +1,79 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "file_descriptor.hh"
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "peek_iov on an empty stream", 8 };
+
+      test.execute( PeekIov { {} } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_iov across the ring wrap point", 8 };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( PeekIov { { "abcdef" } } );
+      test.execute( Pop { 5 } );
+      test.execute( Push { "ghijk" } );
+      test.execute( PeekOnce { "fgh" } );
+      test.execute( PeekIov { { "fgh", "ijk" } } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekIov { { "jk" } } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_iov covers ring and adopted chunks", 16 };
+
+      test.execute( Push { "ab" } );
+      test.execute( PushMoved { "cde" } );
+      test.execute( Push { "f" } );
+      test.execute( PeekIov { { "ab", "cde", "f" } } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekIov { { "de", "f" } } );
+    }
+
+    {
+      // write() drains every buffered region to a file descriptor with one writev
+      array<int, 2> fds {};
+      if ( ::pipe( fds.data() ) != 0 ) {
+        throw runtime_error( "pipe() failed" );
+      }
+      FileDescriptor read_end { fds[0] };
+      FileDescriptor write_end { fds[1] };
+
+      ByteStream bs { 8 };
+      bs.writer().push( "abcdef" );
+      bs.reader().pop( 5 );
+      bs.writer().push( "ghijk" );
+      bs.writer().push( string { "lm" } );
+
+      if ( write( bs.reader(), write_end ) != 8 or bs.reader().bytes_buffered() != 0 ) {
+        throw runtime_error( "write() did not drain the ByteStream" );
+      }
+      if ( write_end.write_count() != 1 ) {
+        throw runtime_error( "write() used more than one system call" );
+      }
+
+      string got;
+      read_end.read( got );
+      if ( got != "fghijklm" ) {
+        throw runtime_error( "write() produced \"" + got + "\" instead of \"fghijklm\"" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,5 +1,7 @@
+#include "allocation_counter.hh"
 #include "byte_stream.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <fstream>
@@ -86,9 +88,70 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
   }
 }
 
+// Alternate moved and copied writes: each copy lands in the ring behind the chunk adopted before it
+void mixed_push_test( const size_t input_len, const size_t capacity, const size_t write_size )
+{
+  string data( input_len, 0 );
+  default_random_engine rd { 789 };
+  uniform_int_distribution<char> ud;
+  generate( data.begin(), data.end(), [&] { return ud( rd ); } );
+
+  queue<string> split_data;
+  for ( size_t i = 0; i < data.size(); i += write_size ) {
+    split_data.emplace( data.substr( i, write_size ) );
+  }
+
+  ByteStream bs { capacity };
+  string output_data;
+  output_data.reserve( data.size() );
+  bool move_next = true;
+
+  const uint64_t allocations_before = allocations;
+  const auto start_time = steady_clock::now();
+  while ( not bs.reader().is_finished() ) {
+    if ( split_data.empty() ) {
+      if ( not bs.writer().is_closed() ) {
+        bs.writer().close();
+      }
+    } else if ( split_data.front().size() <= bs.writer().available_capacity() ) {
+      if ( move_next ) {
+        bs.writer().push( move( split_data.front() ) );
+      } else {
+        bs.writer().push( split_data.front() );
+      }
+      split_data.pop();
+      move_next = !move_next;
+    }
+
+    if ( bs.reader().bytes_buffered() ) {
+      const auto peeked = bs.reader().peek().substr( 0, 1024 );
+      output_data += peeked;
+      bs.reader().pop( peeked.size() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations_made = allocations - allocations_before;
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto gigabits_per_second = 8 * static_cast<double>( input_len ) / test_duration.count() / 1e9;
+  const auto allocations_per_MB = static_cast<double>( allocations_made ) * 1e6 / static_cast<double>( input_len );
+
+  cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size
+       << ", moved and copied writes alternating, reached " << fixed << setprecision( 2 ) << gigabits_per_second
+       << " Gbit/s (" << setprecision( 1 ) << allocations_per_MB << " allocations/MB).\n";
+}
+
 void program_body()
 {
   speed_test( 1e7, 32768, 789, 1500, 128 );
+  speed_test( 1e7, 65536, 789, 1500, 1 );
+  speed_test( 1e7, 65536, 789, 1500, 1024 );
+  speed_test( 1e7, 65536, 789, 1500, 65536 );
+  mixed_push_test( 1e7, 65536, 1500 );
 }
 
 int main()
@@ -34,6 +34,20 @@ struct Push : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.writer().push( data_ ); }
 };
 
+struct PushMoved : public Push
+{
+  using Push::Push;
+  std::string description() const override
+  {
+    return "push moved \"" + Printer::prettify( data_ ) + "\" to the stream";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    std::string data = data_;
+    bs.writer().push( std::move( data ) );
+  }
+};
+
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
@@ -55,6 +69,15 @@ struct Pop : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.reader().pop( len_ ); }
 };
 
+struct SetCapacity : public Action<ByteStream>
+{
+  uint64_t capacity_;
+
+  explicit SetCapacity( uint64_t capacity ) : capacity_( capacity ) {}
+  std::string description() const override { return "set_capacity( " + std::to_string( capacity_ ) + " )"; }
+  void execute( ByteStream& bs ) const override { bs.writer().set_capacity( capacity_ ); }
+};
+
 /* expectations */
 
 struct Peek : public Expectation<ByteStream>
@@ -107,6 +130,69 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekIov : public Expectation<ByteStream>
+{
+  std::vector<std::string> regions_;
+
+  explicit PeekIov( std::vector<std::string> regions ) : regions_( move( regions ) ) {}
+
+  std::string description() const override
+  {
+    std::string desc = "peek_iov() gives";
+    for ( const auto& region : regions_ ) {
+      desc += " \"" + Printer::prettify( region ) + "\"";
+    }
+    return desc;
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    if ( bs.reader().buffered_regions() != regions_.size() ) {
+      throw ExpectationViolation { "buffered_regions", regions_.size(), bs.reader().buffered_regions() };
+    }
+    std::vector<std::string_view> got( regions_.size() + 1 );
+    got.resize( bs.reader().peek_iov( got ) );
+    if ( got.size() != regions_.size() ) {
+      throw ExpectationViolation { "peek_iov() regions", regions_.size(), got.size() };
+    }
+    for ( size_t i = 0; i < got.size(); i++ ) {
+      if ( got[i] != regions_[i] ) {
+        throw ExpectationViolation { "Expected region " + std::to_string( i ) + " to be \""
+                                     + Printer::prettify( regions_[i] ) + "\", but found \""
+                                     + Printer::prettify( got[i] ) + "\"" };
+      }
+    }
+  }
+};
+
+struct PopBuffer : public Expectation<ByteStream>
+{
+  std::string output_;
+  bool shared_;
+
+  PopBuffer( std::string output, bool shared ) : output_( move( output ) ), shared_( shared ) {}
+
+  std::string description() const override
+  {
+    return "pop_buffer() gives \"" + Printer::prettify( output_ ) + "\" "
+           + ( shared_ ? "sharing the stream's storage" : "in storage of its own" );
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const char* front = bs.reader().peek().data();
+    const Buffer buffer = bs.reader().pop_buffer( output_.size() );
+    const std::string_view got = buffer; // must outlive the bytes' removal from the stream
+    if ( got != output_ ) {
+      throw ExpectationViolation { "Expected pop_buffer() to give \"" + Printer::prettify( output_ )
+                                   + "\", but found \"" + Printer::prettify( got ) + "\"" };
+    }
+    if ( ( got.data() == front ) != shared_ ) {
+      throw ExpectationViolation { "pop_buffer() sharing storage", shared_, !shared_ };
+    }
+  }
+};
+
 struct IsClosed : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
@@ -142,6 +228,13 @@ struct BufferEmpty : public ExpectBool<ByteStream>
   bool value( ByteStream& bs ) const override { return bs.reader().bytes_buffered() == 0; }
 };
 
+struct Capacity : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "capacity"; }
+  size_t value( ByteStream& bs ) const override { return bs.writer().capacity(); }
+};
+
 struct AvailableCapacity : public ExpectNumber<ByteStream, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
@@ -156,6 +249,20 @@ struct BytesPushed : public ExpectNumber<ByteStream, uint64_t>
   size_t value( ByteStream& bs ) const override { return bs.writer().bytes_pushed(); }
 };
 
+struct BytesCopied : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "bytes_copied"; }
+  size_t value( ByteStream& bs ) const override { return bs.writer().bytes_copied(); }
+};
+
+struct BytesAdopted : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "bytes_adopted"; }
+  size_t value( ByteStream& bs ) const override { return bs.writer().bytes_adopted(); }
+};
+
 struct BytesPopped : public ExpectNumber<ByteStream, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
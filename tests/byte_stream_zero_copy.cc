@@ -0,0 +1,151 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "moved push is adopted", 15 };
+
+      test.execute( PushMoved { "cat" } );
+      test.execute( BytesPushed { 3 } );
+      test.execute( BytesBuffered { 3 } );
+      test.execute( AvailableCapacity { 12 } );
+      test.execute( BytesCopied { 0 } );
+      test.execute( BytesAdopted { 3 } );
+      test.execute( PeekOnce { "cat" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekOnce { "at" } );
+      test.execute( Pop { 2 } );
+      test.execute( BufferEmpty { true } );
+      test.execute( BytesPopped { 3 } );
+      test.execute( AvailableCapacity { 15 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "moved push is truncated to capacity", 4 };
+
+      test.execute( PushMoved { "catalog" } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( BytesAdopted { 4 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PushMoved { "dog" } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( Peek { "cata" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "copied and moved pushes keep their order", 20 };
+
+      test.execute( Push { "ab" } );
+      test.execute( PushMoved { "cde" } );
+      test.execute( Push { "fg" } );
+      test.execute( PushMoved { "hij" } );
+      test.execute( BytesCopied { 4 } );
+      test.execute( BytesAdopted { 6 } );
+      test.execute( BytesBuffered { 10 } );
+      test.execute( PeekOnce { "ab" } );
+      test.execute( Peek { "abcdefghij" } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekOnce { "de" } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekOnce { "hij" } );
+      test.execute( Push { "kl" } );
+      test.execute( Peek { "hijkl" } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "hijkl" } );
+      test.execute( IsFinished { true } );
+      test.execute( BytesPopped { 12 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "ring wraps after adopted chunks drain", 6 };
+
+      test.execute( Push { "abcd" } );
+      test.execute( Pop { 3 } );
+      test.execute( PushMoved { "ef" } );
+      test.execute( Push { "g" } );
+      test.execute( Peek { "defg" } );
+      test.execute( Pop { 4 } );
+      test.execute( Push { "hijklm" } );
+      test.execute( Peek { "hijklm" } );
+      test.execute( BytesCopied { 11 } );
+      test.execute( BytesAdopted { 2 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "copied pushes behind an adopted chunk share the ring", 8 };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( Pop { 5 } );
+      test.execute( PushMoved { "gh" } );
+      test.execute( Push { "ijkl" } );
+      test.execute( BytesCopied { 10 } );
+      test.execute( BytesAdopted { 2 } );
+      test.execute( Peek { "fghijkl" } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekOnce { "ij" } );
+      test.execute( Pop { 2 } );
+      test.execute( PushMoved { "mn" } );
+      test.execute( Push { "op" } );
+      test.execute( Peek { "klmnop" } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "klmnop" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "pop_buffer shares adopted chunks", 64 };
+
+      // long enough that the string's bytes live on the heap, and move with it
+      test.execute( PushMoved { "the quick brown fox jumps over the lazy dog" } );
+      test.execute( PopBuffer { "the quick brown fox", true } );
+      test.execute( BytesPopped { 19 } );
+      test.execute( PopBuffer { " jumps over the lazy dog", true } );
+      test.execute( BufferEmpty { true } );
+      test.execute( AvailableCapacity { 64 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "pop_buffer copies ring bytes and slices that span chunks", 128 };
+
+      test.execute( Push { "ab" } );
+      test.execute( PushMoved { "cdefghijklmnopqrstuvwxyz0123456789" } );
+      test.execute( PushMoved { "ABCDEFGHIJKLMNOPQRSTUVWXYZ" } );
+      test.execute( PopBuffer { "abc", false } );
+      test.execute( PopBuffer { "defghijklmnopqrstuvwxyz012345678", true } );
+      test.execute( PopBuffer { "9ABC", false } );
+      test.execute( PopBuffer { "DEFGHIJKLMNOPQRSTUVWXYZ", true } );
+      test.execute( BufferEmpty { true } );
+      test.execute( Push { "hij" } );
+      test.execute( PopBuffer { "hi", false } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "j" } );
+      test.execute( IsFinished { true } );
+      test.execute( BytesPopped { 65 } );
+    }
+
+    {
+      // A copy of a Buffer shares its storage, so releasing one copy mustn't take the other's bytes
+      const Buffer original { string { "the quick brown fox jumps over the lazy dog" } };
+      Buffer copy = original;
+      const string released = copy.release();
+      if ( released != string_view { original } || string_view { original }.size() != 43 ) {
+        throw runtime_error( "releasing a copy of a Buffer emptied the original" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,254 @@
+#include "allocation_counter.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// What a simulated link does to each message it carries, as probabilities
+struct Impairments
+{
+  double loss {};
+  double reorder {}; // held back 1-3 ms longer, so the messages sent after it overtake it
+  double duplication {};
+};
+
+// One direction of a link that delivers messages 1 ms after they are sent, unless it drops, reorders or
+// duplicates them
+template<class Message>
+class Link
+{
+  static constexpr uint64_t delay_ms = 1;
+  static constexpr uint64_t max_extra_delay_ms = 3;
+
+  const Impairments& impairments_;
+  default_random_engine& rng_;
+  array<vector<Message>, 8> slots_ {}; // by arrival time, modulo the number of slots
+  size_t in_flight_ {};
+
+  bool happens( double probability )
+  {
+    return probability > 0 and uniform_real_distribution<double> {}( rng_ ) < probability;
+  }
+
+  void schedule( Message msg, uint64_t arrival_ms )
+  {
+    slots_[arrival_ms % slots_.size()].push_back( move( msg ) );
+    ++in_flight_;
+  }
+
+public:
+  Link( const Impairments& impairments, default_random_engine& rng ) : impairments_( impairments ), rng_( rng ) {}
+
+  void send( Message msg, uint64_t now_ms )
+  {
+    if ( happens( impairments_.loss ) ) {
+      return;
+    }
+    uint64_t arrival_ms = now_ms + delay_ms;
+    if ( happens( impairments_.reorder ) ) {
+      arrival_ms += uniform_int_distribution<uint64_t> { 1, max_extra_delay_ms }( rng_ );
+    }
+    if ( happens( impairments_.duplication ) ) {
+      schedule( msg, arrival_ms );
+    }
+    schedule( move( msg ), arrival_ms );
+  }
+
+  // Hand every message due at `now_ms` to `receive`, in the order they were sent
+  template<class Receive>
+  void deliver( uint64_t now_ms, Receive&& receive )
+  {
+    auto& slot = slots_[now_ms % slots_.size()];
+    in_flight_ -= slot.size();
+    for ( auto& msg : slot ) {
+      receive( move( msg ) );
+    }
+    slot.clear();
+  }
+
+  bool empty() const { return in_flight_ == 0; }
+};
+
+// One end of the connection: it sends `data` to its peer, and checks that the peer sends it the same
+struct Endpoint
+{
+  ByteStream outbound;
+  TCPSender sender;
+  ByteStream inbound { capacity };
+  Reassembler reassembler {};
+  TCPReceiver receiver {};
+  queue<string> writes {}; // what the application has left to write
+  uint64_t bytes_checked {};
+
+  static constexpr uint64_t capacity = 1 << 20;
+
+  Endpoint( uint32_t isn, uint64_t mss )
+    : outbound( capacity ), sender( TCPConfig::TIMEOUT_DFLT, Wrap32 { isn }, mss )
+  {
+    sender.enable_window_scaling();
+    sender.enable_adaptive_RTO( 10, 1000 );
+    sender.enable_fast_retransmit();
+    receiver.set_window_scale( 5 ); // enough for the whole stream
+  }
+
+  void write()
+  {
+    while ( not writes.empty() and writes.front().size() <= outbound.writer().available_capacity() ) {
+      outbound.writer().push( move( writes.front() ) );
+      writes.pop();
+    }
+    if ( writes.empty() and not outbound.writer().is_closed() ) {
+      outbound.writer().close();
+    }
+  }
+
+  void read( const string& data )
+  {
+    while ( inbound.reader().bytes_buffered() ) {
+      const string_view bytes = inbound.reader().peek();
+      if ( data.compare( bytes_checked, bytes.size(), bytes ) != 0 ) {
+        throw runtime_error( "The bytes read differ from the bytes written." );
+      }
+      bytes_checked += bytes.size();
+      inbound.reader().pop( bytes.size() );
+    }
+  }
+
+  bool done( const string& data ) const
+  {
+    return bytes_checked == data.size() and inbound.reader().is_finished() and outbound.reader().is_finished()
+           and sender.sequence_numbers_in_flight() == 0;
+  }
+};
+
+/*
+ * Two endpoints send each other `input_len` bytes at once, in 64 KiB writes, through in-memory links with a 1 ms
+ * delay and the given impairments, in 1 ms steps of virtual time. Every segment a receiver takes in is
+ * acknowledged (with SACK blocks), and the application reads and checks everything it can after each step.
+ * Reports the wall-clock rate of the whole pipeline: TCPSender, links, TCPReceiver, Reassembler and ByteStream.
+ */
+void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t mss,         // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const Impairments& impairments )
+{
+  constexpr size_t write_size = 65536;
+  constexpr uint64_t max_simulated_ms = 600000;
+
+  default_random_engine rng { random_seed };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rng );
+    }
+    return ret;
+  }();
+
+  array<Endpoint, 2> endpoints { Endpoint { 1000, mss }, Endpoint { 2000, mss } };
+  for ( auto& endpoint : endpoints ) {
+    for ( size_t i = 0; i < data.size(); i += write_size ) {
+      endpoint.writes.emplace( data.substr( i, write_size ) );
+    }
+  }
+
+  // segments[i] carries what endpoints[i] sends, and acks[i] what endpoints[i] acknowledges
+  array<Link<TCPSenderMessage>, 2> segments { Link<TCPSenderMessage> { impairments, rng },
+                                              Link<TCPSenderMessage> { impairments, rng } };
+  array<Link<TCPReceiverMessage>, 2> acks { Link<TCPReceiverMessage> { impairments, rng },
+                                            Link<TCPReceiverMessage> { impairments, rng } };
+
+  uint64_t now_ms = 0;
+  size_t segments_sent = 0;
+  const uint64_t allocations_before = allocations;
+  const auto start_time = steady_clock::now();
+  while ( not endpoints[0].done( data ) or not endpoints[1].done( data ) ) {
+    if ( now_ms > max_simulated_ms ) {
+      throw runtime_error( "The connection stalled." );
+    }
+
+    for ( size_t i = 0; i < 2; ++i ) {
+      Endpoint& local = endpoints[i];
+      segments[1 - i].deliver( now_ms, [&]( TCPSenderMessage msg ) {
+        local.receiver.receive( move( msg ), local.reassembler, local.inbound.writer() );
+        acks[i].send( local.receiver.send( local.inbound.writer(), local.reassembler ), now_ms );
+      } );
+      acks[1 - i].deliver( now_ms, [&]( const TCPReceiverMessage& msg ) { local.sender.receive( msg ); } );
+      local.read( data );
+    }
+
+    for ( size_t i = 0; i < 2; ++i ) {
+      Endpoint& local = endpoints[i];
+      local.write();
+      local.sender.push( local.outbound.reader() );
+      while ( auto msg = local.sender.maybe_send() ) {
+        ++segments_sent;
+        segments[i].send( move( *msg ), now_ms );
+      }
+    }
+
+    ++now_ms;
+    for ( auto& endpoint : endpoints ) {
+      endpoint.sender.tick( 1 );
+      endpoint.receiver.tick( 1 );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations_made = allocations - allocations_before;
+
+  const auto bytes_moved = static_cast<double>( 2 * input_len );
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto gigabits_per_second = 8 * bytes_moved / test_duration.count() / 1e9;
+  auto segments_per_second = static_cast<double>( segments_sent ) / test_duration.count();
+  auto allocations_per_MB = static_cast<double>( allocations_made ) * 1e6 / bytes_moved;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCP loopback with MSS=" << mss << ", loss=" << impairments.loss * 100
+       << "%, reorder=" << impairments.reorder * 100 << "%, duplication=" << impairments.duplication * 100
+       << "% reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s (" << setprecision( 0 )
+       << segments_per_second << " segments/s, " << setprecision( 1 ) << allocations_per_MB
+       << " allocations/MB, " << now_ms << " ms simulated).\n"
+       << defaultfloat;
+
+  debug_output << "             TCP loopback throughput (loss=" << impairments.loss * 100 << "%): " << fixed
+               << setprecision( 2 ) << gigabits_per_second << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "TCP loopback did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 5e7, TCPConfig::mss_for_mtu( 1500 ), 789, {} );
+  speed_test( 5e7, TCPConfig::mss_for_mtu( 9000 ), 789, {} );
+  speed_test( 2e7, TCPConfig::mss_for_mtu( 1500 ), 789, { 0.01, 0.01, 0.01 } );
+  speed_test( 1e7, TCPConfig::mss_for_mtu( 1500 ), 789, { 0.05, 0.05, 0.05 } );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
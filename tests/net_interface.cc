@@ -320,6 +320,183 @@ int main()
         serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
       test.execute( ExpectNoFrame {} );
     }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth1 = random_private_ethernet_address();
+      const EthernetAddress remote_eth2 = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "a reply sends just the datagrams waiting for it", local_eth, Address( "10.0.0.1", 0 ) };
+
+      const auto datagram = make_datagram( "5.6.7.8", "13.12.11.10" );
+      const auto datagram2 = make_datagram( "5.6.7.8", "13.12.11.11" );
+      const auto datagram3 = make_datagram( "5.6.7.8", "13.12.11.12" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.19", 0 ) } );
+      test.execute( SendDatagram { datagram3, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.19" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // the second next hop answers first
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth2,
+          local_eth,
+          EthernetHeader::TYPE_ARP, // NOLINTNEXTLINE(*-suspicious-*)
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth2, "10.0.0.19", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth2, EthernetHeader::TYPE_IPv4, serialize( datagram2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // then the first, whose datagrams go out in the order they were sent
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth1,
+          local_eth,
+          EthernetHeader::TYPE_ARP, // NOLINTNEXTLINE(*-suspicious-*)
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth1, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth1, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth1, EthernetHeader::TYPE_IPv4, serialize( datagram3 ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // a second reply has nothing left to send
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth1,
+          local_eth,
+          EthernetHeader::TYPE_ARP, // NOLINTNEXTLINE(*-suspicious-*)
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth1, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "pending datagrams per next hop are bounded", local_eth, Address( "10.0.0.1", 0 ) };
+      test.execute( SetPendingLimits { 2, 1 << 20 } );
+
+      const auto datagram = make_datagram( "5.6.7.8", "13.12.11.10" );
+      const auto datagram2 = make_datagram( "5.6.7.8", "13.12.11.11" );
+      const auto datagram3 = make_datagram( "5.6.7.8", "13.12.11.12" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.5", 0 ) } );
+      test.execute( SendDatagram { datagram3, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectDatagramsQueued { 2 } );
+      test.execute( ExpectDatagramsDropped { 1 } );
+      test.execute( ExpectPendingBytes { 50 } );
+
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP, // NOLINTNEXTLINE(*-suspicious-*)
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectDatagramsFlushed { 2 } );
+      test.execute( ExpectPendingBytes { 0 } );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "pending bytes are bounded across next hops", local_eth, Address( "10.0.0.1", 0 ) };
+      test.execute( SetPendingLimits { 100, 60 } );
+
+      // each datagram is 25 bytes: a 20-byte header and "hello"
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.10" ), Address( "10.0.0.5", 0 ) } );
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.10" ), Address( "10.0.0.6", 0 ) } );
+      test.execute( ExpectPendingBytes { 50 } );
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.10" ), Address( "10.0.0.7", 0 ) } );
+      test.execute( ExpectPendingBytes { 50 } );
+      test.execute( ExpectDatagramsQueued { 2 } );
+      test.execute( ExpectDatagramsDropped { 1 } );
+
+      // the third next hop is still asked about, for the datagrams that come later
+      for ( const auto* next_hop : { "10.0.0.5", "10.0.0.6", "10.0.0.7" } ) {
+        test.execute( ExpectFrame { make_frame(
+          local_eth,
+          ETHERNET_BROADCAST,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, next_hop ) ) ) } );
+      }
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "datagrams that wait too long are dropped", local_eth, Address( "10.0.0.1", 0 ) };
+      const auto arp_request = make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) );
+
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.10" ), Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { arp_request } );
+      test.execute( Tick { 3000 } );
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.11" ), Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // after 5 s the first is dropped, and the request is repeated for the second
+      test.execute( Tick { 2000 } );
+      test.execute( ExpectDatagramsDropped { 1 } );
+      test.execute( ExpectPendingBytes { 25 } );
+      test.execute( ExpectFrame { arp_request } );
+      test.execute( ExpectNoFrame {} );
+
+      // then the second is dropped, and with nothing waiting, the request isn't repeated
+      test.execute( Tick { 3000 } );
+      test.execute( ExpectDatagramsDropped { 2 } );
+      test.execute( ExpectPendingBytes { 0 } );
+      test.execute( Tick { 2000 } );
+      test.execute( ExpectNoFrame {} );
+
+      // a new datagram asks again at once, and only it is sent when the reply comes
+      const auto datagram3 = make_datagram( "5.6.7.8", "13.12.11.12" );
+      test.execute( SendDatagram { datagram3, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { arp_request } );
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP, // NOLINTNEXTLINE(*-suspicious-*)
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram3 ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectDatagramsQueued { 3 } );
+      test.execute( ExpectDatagramsFlushed { 1 } );
+      test.execute( ExpectDatagramsDropped { 2 } );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return EXIT_FAILURE;
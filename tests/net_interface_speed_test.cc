@@ -0,0 +1,135 @@
+#include "arp_message.hh"
+#include "network_interface.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * An interface with `neighbours` next hops it has not resolved yet is given `datagrams` to send, spread evenly
+ * across them. Then every neighbour answers its ARP request, and the interface idles in 1 ms ticks until the
+ * mappings have expired. Reports the cost of each phase.
+ */
+void speed_test( const uint32_t neighbours, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t datagrams )
+{
+  const EthernetAddress local_eth { 0x02, 0, 0, 0, 0, 1 };
+  const Address local_ip { "10.0.0.1", 0 };
+  NetworkInterface interface { local_eth, local_ip };
+  interface.set_pending_limits( datagrams, SIZE_MAX ); // hold them all
+
+  const auto neighbour_ip = [&]( uint32_t i ) { return local_ip.ipv4_numeric() + 1 + i; };
+  const auto neighbour_eth = [&]( uint32_t i ) {
+    return EthernetAddress { 0x02, 0, static_cast<uint8_t>( i >> 24 ), static_cast<uint8_t>( i >> 16 ),
+                             static_cast<uint8_t>( i >> 8 ), static_cast<uint8_t>( i ) };
+  };
+
+  InternetDatagram dgram;
+  dgram.payload.emplace_back( string( 64, 'x' ) );
+  dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.size();
+  dgram.header.compute_checksum();
+
+  vector<Address> next_hops;
+  vector<EthernetFrame> replies;
+  for ( uint32_t i = 0; i < neighbours; ++i ) {
+    next_hops.push_back( Address::from_ipv4_numeric( neighbour_ip( i ) ) );
+
+    ARPMessage reply;
+    reply.opcode = ARPMessage::OPCODE_REPLY;
+    reply.sender_ethernet_address = neighbour_eth( i );
+    reply.sender_ip_address = neighbour_ip( i );
+    reply.target_ethernet_address = local_eth;
+    reply.target_ip_address = local_ip.ipv4_numeric();
+    EthernetFrame frame;
+    frame.header = { local_eth, neighbour_eth( i ), EthernetHeader::TYPE_ARP };
+    frame.payload = serialize( reply );
+    replies.push_back( move( frame ) );
+  }
+
+  size_t frames = 0;
+  const auto drain = [&] {
+    while ( interface.maybe_send().has_value() ) {
+      ++frames;
+    }
+  };
+
+  // Queue the datagrams, which sends one ARP request per neighbour
+  const auto queue_start = steady_clock::now();
+  for ( size_t i = 0; i < datagrams; ++i ) {
+    interface.send_datagram( dgram, next_hops[i % neighbours] );
+  }
+  drain();
+  const auto queue_time = duration_cast<duration<double>>( steady_clock::now() - queue_start );
+  if ( frames != neighbours ) {
+    throw runtime_error( "Expected one ARP request per neighbour." );
+  }
+
+  // Every neighbour answers, which sends its datagrams
+  frames = 0;
+  const auto reply_start = steady_clock::now();
+  for ( const auto& reply : replies ) {
+    interface.recv_frame( reply );
+    drain();
+  }
+  const auto reply_time = duration_cast<duration<double>>( steady_clock::now() - reply_start );
+  if ( frames != datagrams || interface.datagrams_flushed() != datagrams ) {
+    throw runtime_error( "Expected every queued datagram to be sent." );
+  }
+
+  // Idle until the mappings expire
+  constexpr uint64_t idle_ms = 31000;
+  const auto idle_start = steady_clock::now();
+  for ( uint64_t t = 0; t < idle_ms; ++t ) {
+    interface.tick( 1 );
+  }
+  const auto idle_time = duration_cast<duration<double>>( steady_clock::now() - idle_start );
+
+  // With the mappings gone, sending again starts a new ARP request
+  frames = 0;
+  interface.send_datagram( dgram, next_hops.front() );
+  drain();
+  if ( frames != 1 ) {
+    throw runtime_error( "Expected the ARP mappings to expire." );
+  }
+
+  const double queue_ns = queue_time.count() * 1e9 / static_cast<double>( datagrams );
+  const double reply_ns = reply_time.count() * 1e9 / static_cast<double>( neighbours );
+  const double tick_ns = idle_time.count() * 1e9 / static_cast<double>( idle_ms );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "NetworkInterface with " << neighbours << " neighbours and " << datagrams << " datagrams: " << fixed
+       << setprecision( 0 ) << queue_ns << " ns per queued datagram, " << reply_ns
+       << " ns per ARP reply (with its datagrams), " << tick_ns << " ns per 1 ms tick.\n";
+
+  debug_output << "             NetworkInterface ARP reply (" << neighbours << " neighbours): " << fixed
+               << setprecision( 0 ) << reply_ns << " ns; tick: " << tick_ns << " ns\n";
+}
+
+void program_body()
+{
+  speed_test( 100, 1000 );
+  speed_test( 10000, 100000 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -135,6 +135,54 @@ struct Tick : public Action<NetworkInterface>
   explicit Tick( const size_t ms ) : _ms( ms ) {}
 };
 
+struct SetPendingLimits : public Action<NetworkInterface>
+{
+  size_t datagrams_per_hop_;
+  size_t bytes_;
+
+  std::string description() const override
+  {
+    return "limit pending datagrams to " + std::to_string( datagrams_per_hop_ ) + " per next hop and "
+           + std::to_string( bytes_ ) + " bytes";
+  }
+  void execute( NetworkInterface& interface ) const override
+  {
+    interface.set_pending_limits( datagrams_per_hop_, bytes_ );
+  }
+
+  SetPendingLimits( size_t datagrams_per_hop, size_t bytes )
+    : datagrams_per_hop_( datagrams_per_hop ), bytes_( bytes )
+  {}
+};
+
+struct ExpectDatagramsQueued : public ExpectNumber<NetworkInterface, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "datagrams_queued"; }
+  uint64_t value( NetworkInterface& interface ) const override { return interface.datagrams_queued(); }
+};
+
+struct ExpectDatagramsFlushed : public ExpectNumber<NetworkInterface, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "datagrams_flushed"; }
+  uint64_t value( NetworkInterface& interface ) const override { return interface.datagrams_flushed(); }
+};
+
+struct ExpectDatagramsDropped : public ExpectNumber<NetworkInterface, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "datagrams_dropped"; }
+  uint64_t value( NetworkInterface& interface ) const override { return interface.datagrams_dropped(); }
+};
+
+struct ExpectPendingBytes : public ExpectNumber<NetworkInterface, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pending_bytes"; }
+  size_t value( NetworkInterface& interface ) const override { return interface.pending_bytes(); }
+};
+
 inline std::string summary( const EthernetFrame& frame )
 {
   std::string out = frame.header.to_string() + ", payload: ";
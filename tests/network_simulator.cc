@@ -0,0 +1,152 @@
+#include "congestion_control.hh"
+#include "network_simulator.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( !condition ) {
+    throw runtime_error( what );
+  }
+}
+
+constexpr uint64_t MBIT = 1000000;
+
+void use_newreno( TCPSender& sender, TCPReceiver& /* receiver */ )
+{
+  sender.enable_fast_retransmit();
+  sender.set_congestion_control( make_unique<NewReno>( sender.max_payload_size() ) );
+}
+
+// `flows` hosts send `bytes` each to one more host, whose downlink is the only bottleneck
+void fan_in( NetworkSimulator& sim, size_t flows, uint64_t bytes, uint64_t queue_bytes )
+{
+  const NetworkSimulator::LinkConfig fast { 100 * MBIT, 5, 1 << 20 };
+  const size_t server = sim.add_host( fast, { 10 * MBIT, 5, queue_bytes } );
+  for ( size_t i = 0; i < flows; ++i ) {
+    const size_t client = sim.add_host( fast, fast );
+    sim.add_flow( client, server, { bytes, 0, TCPConfig::DEFAULT_CAPACITY, use_newreno } );
+  }
+}
+
+}
+
+int main()
+{
+  try {
+    {
+      // One flow over 10 Mbit/s links with 5 ms of delay each way delivers everything, slower than the link
+      NetworkSimulator sim;
+      const NetworkSimulator::LinkConfig link { 10 * MBIT, 5, 1 << 20 };
+      const size_t a = sim.add_host( link, link );
+      const size_t b = sim.add_host( link, link );
+      const size_t flow = sim.add_flow( a, b, { 500000 } );
+      expect( sim.run_until_done( 10000 ), "the flow completes" );
+
+      const auto& stats = sim.flow_stats( flow );
+      expect( stats.bytes_delivered == 500000, "every byte is delivered" );
+      expect( stats.completed_ms.has_value() && *stats.completed_ms == sim.now_ms() - 1, "it completed last" );
+      expect( stats.sequence_numbers_retransmitted == 0, "nothing is lost" );
+      expect( stats.segments_sent >= 500000 / TCPConfig::mss_for_mtu( 1500 ), "segments are at most an MSS" );
+      expect( sim.goodput_bps( flow ) > 1 * MBIT && sim.goodput_bps( flow ) < 10 * MBIT,
+              "the goodput is below the link rate" );
+      expect( sim.fairness() == 1, "one flow is perfectly fair" );
+      expect( sim.uplink_stats( a ).frames_dropped == 0, "a deep queue drops nothing" );
+      expect( sim.uplink_stats( a ).bytes_sent > 500000, "the data crossed a's uplink" );
+      expect( sim.downlink_stats( b ).frames_sent == sim.uplink_stats( a ).frames_sent,
+              "and b's downlink, through the router" );
+      expect( sim.downlink_stats( a ).frames_sent > 0, "acks and ARP come back" );
+      expect( sim.arp_datagrams_queued() >= 2, "the first datagrams each way waited for ARP" );
+      expect( sim.arp_datagrams_dropped() == 0, "none were dropped" );
+    }
+
+    {
+      // A flow starts when it is told to, and its goodput counts from then
+      NetworkSimulator sim;
+      const NetworkSimulator::LinkConfig link { 10 * MBIT, 1, 1 << 20 };
+      const size_t a = sim.add_host( link, link );
+      const size_t b = sim.add_host( link, link );
+      const size_t early = sim.add_flow( a, b, { 10000 } );
+      const size_t late = sim.add_flow( b, a, { 10000, 500 } );
+      for ( int i = 0; i < 400; ++i ) {
+        sim.tick();
+      }
+      expect( sim.flow_stats( early ).completed_ms.has_value(), "the early flow is done" );
+      expect( sim.flow_stats( late ).segments_sent == 0, "the late one hasn't started" );
+      expect( sim.run_until_done( 1000 ), "and then completes" );
+      expect( *sim.flow_stats( late ).completed_ms > 500, "after its start" );
+      expect( sim.goodput_bps( late ) > 0, "with goodput measured from its start" );
+    }
+
+    {
+      // Flows sharing a bottleneck build a queue there and get similar shares of it
+      NetworkSimulator sim;
+      fan_in( sim, 4, 1000000, 1 << 20 );
+      expect( sim.run_until_done( 60000 ), "the flows complete" );
+      expect( sim.fairness() > 0.9, "they share the bottleneck fairly" );
+      expect( sim.downlink_stats( 0 ).mean_queueing_delay_ms() > 1, "a queue builds at the bottleneck" );
+      expect( sim.downlink_stats( 0 ).max_queueing_delay_us >= sim.downlink_stats( 0 ).queueing_delay_us
+                                                                  / sim.downlink_stats( 0 ).frames_sent,
+              "the maximum delay is at least the mean" );
+      expect( sim.uplink_stats( 1 ).mean_queueing_delay_ms() < 1, "but not on the fast links" );
+    }
+
+    {
+      // A shallow queue drops frames, and the flows recover by retransmitting
+      NetworkSimulator sim;
+      fan_in( sim, 4, 500000, 6000 );
+      expect( sim.run_until_done( 120000 ), "the flows complete despite the losses" );
+      expect( sim.downlink_stats( 0 ).frames_dropped > 0, "the bottleneck dropped frames" );
+      uint64_t retransmitted = 0;
+      for ( size_t i = 0; i < 4; ++i ) {
+        expect( sim.flow_stats( i ).bytes_delivered == 500000, "every byte is delivered" );
+        retransmitted += sim.flow_stats( i ).sequence_numbers_retransmitted;
+      }
+      expect( retransmitted > 0, "the losses were retransmitted" );
+    }
+
+    {
+      // The simulation is deterministic
+      vector<uint64_t> completions[2];
+      for ( auto& completion : completions ) {
+        NetworkSimulator sim;
+        fan_in( sim, 3, 200000, 10000 );
+        expect( sim.run_until_done( 60000 ), "the flows complete" );
+        for ( size_t i = 0; i < 3; ++i ) {
+          completion.push_back( *sim.flow_stats( i ).completed_ms );
+          completion.push_back( sim.flow_stats( i ).segments_sent );
+        }
+      }
+      expect( completions[0] == completions[1], "two runs give the same results" );
+    }
+
+    {
+      // A flow needs two different hosts
+      NetworkSimulator sim;
+      const size_t a = sim.add_host( { MBIT, 1, 10000 }, { MBIT, 1, 10000 } );
+      bool threw = false;
+      try {
+        sim.add_flow( a, a, { 1 } );
+      } catch ( const runtime_error& ) {
+        threw = true;
+      }
+      expect( threw, "a flow from a host to itself is refused" );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
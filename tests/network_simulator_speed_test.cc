@@ -0,0 +1,99 @@
+#include "congestion_control.hh"
+#include "network_simulator.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * `clients` hosts each open one NewReno flow of `bytes` to one of `servers` hosts, starting within the first
+ * 100 ms. Every server's 1 Gbit/s downlink is shared by its clients' flows, behind a 256 KiB queue. Reports how
+ * fast the simulation ran, and the goodput, fairness and queueing delay it found.
+ */
+void speed_test( const size_t clients, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t servers, // NOLINT(bugprone-easily-swappable-parameters)
+                 const uint64_t bytes )
+{
+  constexpr uint64_t mbit = 1000000;
+  constexpr uint64_t capacity = 16384;
+  constexpr uint64_t max_ms = 600000;
+
+  NetworkSimulator sim;
+  const NetworkSimulator::LinkConfig access { 100 * mbit, 2, 1 << 20 };
+  const NetworkSimulator::LinkConfig bottleneck { 1000 * mbit, 2, 256 * 1024 };
+  for ( size_t i = 0; i < servers; ++i ) {
+    sim.add_host( access, bottleneck );
+  }
+  for ( size_t i = 0; i < clients; ++i ) {
+    const size_t client = sim.add_host( access, access );
+    sim.add_flow( client, i % servers, { bytes, i % 100, capacity, []( TCPSender& sender, TCPReceiver& ) {
+                   sender.enable_fast_retransmit();
+                   sender.enable_adaptive_RTO( 200 );
+                   sender.set_congestion_control( make_unique<NewReno>( sender.max_payload_size() ) );
+                 } } );
+  }
+
+  const auto start_time = steady_clock::now();
+  if ( not sim.run_until_done( max_ms ) ) {
+    throw runtime_error( "The flows did not complete." );
+  }
+  const auto test_duration = duration_cast<duration<double>>( steady_clock::now() - start_time );
+
+  uint64_t retransmitted = 0;
+  for ( size_t i = 0; i < clients; ++i ) {
+    retransmitted += sim.flow_stats( i ).sequence_numbers_retransmitted;
+  }
+  double queueing_delay_ms = 0;
+  uint64_t max_queueing_delay_us = 0;
+  uint64_t drops = 0;
+  for ( size_t i = 0; i < servers; ++i ) {
+    queueing_delay_ms += sim.downlink_stats( i ).mean_queueing_delay_ms() / static_cast<double>( servers );
+    max_queueing_delay_us = max( max_queueing_delay_us, sim.downlink_stats( i ).max_queueing_delay_us );
+    drops += sim.downlink_stats( i ).frames_dropped;
+  }
+
+  const double simulated_s = static_cast<double>( sim.now_ms() ) / 1000;
+  const double goodput_mbps = static_cast<double>( clients * bytes ) * 8 / simulated_s / 1e6;
+  const double tick_us = test_duration.count() * 1e6 / static_cast<double>( sim.now_ms() );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "NetworkSimulator with " << clients << " flows to " << servers << " servers: " << fixed
+       << setprecision( 2 ) << simulated_s << " s simulated in " << test_duration.count() << " s ("
+       << setprecision( 0 ) << tick_us << " us per 1 ms tick); goodput " << goodput_mbps << " Mbit/s, fairness "
+       << setprecision( 3 ) << sim.fairness() << ", bottleneck queueing delay " << setprecision( 1 )
+       << queueing_delay_ms << " ms mean and " << static_cast<double>( max_queueing_delay_us ) / 1000
+       << " ms max, " << drops << " drops, " << retransmitted << " sequence numbers retransmitted, "
+       << sim.arp_datagrams_queued() << " datagrams held for ARP.\n";
+
+  debug_output << "             NetworkSimulator (" << clients << " flows): " << fixed << setprecision( 0 )
+               << tick_us << " us per tick\n";
+}
+
+void program_body()
+{
+  speed_test( 100, 1, 1000000 );
+  speed_test( 2000, 20, 50000 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
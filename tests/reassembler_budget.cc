@@ -0,0 +1,70 @@
+#include "reassembler_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "footprint does not grow with fragment count", 65000 };
+
+      test.execute( Insert { "x", 65000 - 1 } );
+      const uint64_t limit = 65000 + 65000 / 8 + 64;
+      test.execute( MemoryUsageAtMost { limit } );
+      for ( uint64_t i = 1; i < 65000; i += 2 ) {
+        test.execute( Insert { "y", i } );
+      }
+      test.execute( BytesPending( 32500 ) );
+      test.execute( MemoryUsageAtMost { limit } );
+      test.execute( BytesDropped( 0 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "budget drops the furthest bytes", 65000 };
+
+      test.execute( SetMemoryBudget { 1152 } ); // 1024 slots plus their 128-byte bitmap
+      test.execute( Insert { string( 100, 'b' ), 1000 } );
+      test.execute( BytesPending( 24 ) );
+      test.execute( BytesDropped( 76 ) );
+      test.execute( MemoryUsageAtMost( 1152 ) );
+      test.execute( Insert { string( 1000, 'a' ), 0 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( BytesPushed( 1024 ) );
+      test.execute( Insert { string( 100, 'b' ), 1000 } );
+      test.execute( BytesPushed( 1100 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "zero budget still accepts in-order data", 65000 };
+
+      test.execute( SetMemoryBudget { 0 } );
+      test.execute( Insert { "def", 3 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( BytesDropped( 3 ) );
+      test.execute( Insert { "abc", 0 } );
+      test.execute( Insert { "def", 3 }.is_last() );
+      test.execute( ReadAll( "abcdef" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "a huge budget is no limit", 65000 };
+
+      test.execute( SetMemoryBudget { uint64_t { 1 } << 62 } );
+      test.execute( Insert { "def", 3 } );
+      test.execute( BytesPending( 3 ) );
+      test.execute( BytesDropped( 0 ) );
+      test.execute( Insert { "abc", 0 } );
+      test.execute( ReadAll( "abcdef" ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -97,6 +97,26 @@ int main()
       test.execute( ReadAll( "c" ) );
     }
 
+    {
+      ReassemblerTestHarness test { "growing the stream's capacity keeps pending bytes", 100 };
+
+      test.execute( Insert { string( 80, 'a' ), 0 } );
+      test.execute( ReadAll( string( 80, 'a' ) ) );
+      test.execute( Insert { string( 20, 'c' ), 90 } ); // across the end of a 100-byte ring
+      test.execute( BytesPending( 20 ) );
+
+      test.execute( SetCapacity { 1000 } );
+      test.execute( Insert { string( 10, 'e' ), 500 } );
+      test.execute( BytesPending( 30 ) );
+      test.execute( BytesDropped( 0 ) );
+
+      test.execute( Insert { string( 10, 'b' ), 80 } );
+      test.execute( BytesPushed( 110 ) );
+      test.execute( Insert { string( 390, 'd' ), 110 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( string( 10, 'b' ) + string( 20, 'c' ) + string( 390, 'd' ) + string( 10, 'e' ) ) );
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
@@ -0,0 +1,70 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "in-order segments take the fast path", 65000 };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( Insert { "efgh", 4 } );
+      test.execute( Insert { "ijkl", 8 }.is_last() );
+      test.execute( BytesPending( 0 ) );
+      test.execute( FastPathInserts( 3 ) );
+      test.execute( TotalInserts( 3 ) );
+      test.execute( ReadAll( "abcdefghijkl" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "fast path merges stored successors", 65000 };
+
+      test.execute( Insert { "ghi", 6 } );
+      test.execute( Insert { "def", 3 } );
+      test.execute( BytesPending( 6 ) );
+      test.execute( FastPathInserts( 0 ) );
+      test.execute( Insert { "abc", 0 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( FastPathInserts( 1 ) );
+      test.execute( ReadAll( "abcdefghi" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "fast path segment overlapping stored bytes", 65000 };
+
+      test.execute( Insert { "cde", 2 } );
+      test.execute( Insert { "gh", 6 } );
+      test.execute( BytesPending( 5 ) );
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( ReadAll( "abcde" ) );
+      test.execute( Insert { "cdef", 2 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( FastPathInserts( 2 ) );
+      test.execute( TotalInserts( 4 ) );
+      test.execute( ReadAll( "fgh" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "fast path respects capacity", 4 };
+
+      test.execute( Insert { "abcdef", 0 } );
+      test.execute( BytesPushed( 4 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcd" ) );
+      test.execute( Insert { "efgh", 4 } );
+      test.execute( FastPathInserts( 2 ) );
+      test.execute( ReadAll( "efgh" ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
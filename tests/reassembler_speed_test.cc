@@ -13,6 +13,12 @@
 using namespace std;
 using namespace std::chrono;
 
+double fast_path_percent( const Reassembler& reassembler )
+{
+  return 100.0 * static_cast<double>( reassembler.fast_path_inserts() )
+         / static_cast<double>( reassembler.total_inserts() );
+}
+
 void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
@@ -73,7 +79,7 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   debug_output.open( "/dev/tty" );
 
   cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+       << gigabits_per_second << " Gbit/s (fast path on " << fast_path_percent( reassembler ) << "% of inserts).\n";
 
   debug_output << "             Reassembler throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
                << " Gbit/s\n";
@@ -83,9 +89,82 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   }
 }
 
+void reorder_speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t segment_len, // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  // Generate the data to be written
+  const string data = [&] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  // Within each window, send the segments back to front, and every segment twice
+  queue<tuple<uint64_t, string, bool>> split_data;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    const size_t window_end = min( window + capacity, data.size() );
+    for ( size_t i = window_end; i > window; ) {
+      const size_t start = i - min( segment_len, i - window );
+      for ( size_t copy = 0; copy < 2; ++copy ) {
+        split_data.emplace( start, data.substr( start, i - start ), i == data.size() );
+      }
+      i = start;
+    }
+  }
+
+  ByteStream stream { capacity };
+  Reassembler reassembler;
+
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  while ( not split_data.empty() ) {
+    auto& next = split_data.front();
+    reassembler.insert( get<uint64_t>( next ), move( get<string>( next ) ), get<bool>( next ), stream.writer() );
+    split_data.pop();
+
+    while ( stream.reader().bytes_buffered() ) {
+      output_data += stream.reader().peek();
+      stream.reader().pop( output_data.size() - stream.reader().bytes_popped() );
+    }
+  }
+
+  const auto stop_time = steady_clock::now();
+
+  if ( not stream.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto bytes_per_second = static_cast<double>( input_len ) / test_duration.count();
+  auto bits_per_second = 8 * bytes_per_second;
+  auto gigabits_per_second = bits_per_second / 1e9;
+
+  cout << "Reassembler with capacity=" << capacity << ", reversed and duplicated " << segment_len
+       << "-byte segments reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s (fast path on "
+       << fast_path_percent( reassembler ) << "% of inserts).\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
 void program_body()
 {
   speed_test( 10000, 1500, 1370 );
+  reorder_speed_test( 1e7, 64000, 1000, 1370 );
+  reorder_speed_test( 1e6, 64000, 16, 1370 );
 }
 
 int main()
@@ -50,6 +50,50 @@ struct BytesPending : public ExpectNumber<StreamAndReassembler, uint64_t>
   uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.bytes_pending(); }
 };
 
+struct FastPathInserts : public ExpectNumber<StreamAndReassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "fast_path_inserts"; }
+  uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.fast_path_inserts(); }
+};
+
+struct TotalInserts : public ExpectNumber<StreamAndReassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "total_inserts"; }
+  uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.total_inserts(); }
+};
+
+struct BytesDropped : public ExpectNumber<StreamAndReassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "bytes_dropped"; }
+  uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.bytes_dropped(); }
+};
+
+struct MemoryUsageAtMost : public Expectation<StreamAndReassembler>
+{
+  uint64_t limit_;
+  explicit MemoryUsageAtMost( uint64_t limit ) : limit_( limit ) {}
+  std::string description() const override { return "memory_usage <= " + std::to_string( limit_ ); }
+  void execute( StreamAndReassembler& sr ) const override
+  {
+    if ( sr.second.memory_usage() > limit_ ) {
+      throw ExpectationViolation { "The Reassembler should have used at most " + std::to_string( limit_ )
+                                   + " bytes of memory, but it used " + std::to_string( sr.second.memory_usage() )
+                                   + "." };
+    }
+  }
+};
+
+struct SetMemoryBudget : public Action<StreamAndReassembler>
+{
+  uint64_t bytes_;
+  explicit SetMemoryBudget( uint64_t bytes ) : bytes_( bytes ) {}
+  std::string description() const override { return "set memory budget to " + std::to_string( bytes_ ); }
+  void execute( StreamAndReassembler& sr ) const override { sr.second.set_memory_budget( bytes_ ); }
+};
+
 struct Insert : public Action<StreamAndReassembler>
 {
   std::string data_;
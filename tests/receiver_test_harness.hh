@@ -56,6 +56,100 @@ struct ExpectWindow : public ExpectNumber<ReceiverSet, uint16_t>
   uint16_t value( ReceiverSet& rs ) const override { return rs.second.send( rs.first.first.writer() ).window_size; }
 };
 
+struct ExpectWindowScale : public ExpectNumber<ReceiverSet, uint8_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "window_scale"; }
+  uint8_t value( ReceiverSet& rs ) const override { return rs.second.send( rs.first.first.writer() ).window_scale; }
+};
+
+struct SetWindowScale : public Action<ReceiverSet>
+{
+  uint8_t shift_;
+
+  explicit SetWindowScale( uint8_t shift ) : shift_( shift ) {}
+  std::string description() const override { return "set window scale to " + std::to_string( shift_ ); }
+  void execute( ReceiverSet& rs ) const override { rs.second.set_window_scale( shift_ ); }
+};
+
+struct EnableDelayedAck : public Action<ReceiverSet>
+{
+  uint64_t timeout_ms_;
+  uint64_t mss_;
+
+  explicit EnableDelayedAck( uint64_t timeout_ms, uint64_t mss ) : timeout_ms_( timeout_ms ), mss_( mss ) {}
+  std::string description() const override
+  {
+    return "enable delayed acks (timeout=" + std::to_string( timeout_ms_ ) + " ms, mss=" + std::to_string( mss_ )
+           + ")";
+  }
+  void execute( ReceiverSet& rs ) const override { rs.second.enable_delayed_ack( timeout_ms_, mss_ ); }
+};
+
+struct Tick : public Action<ReceiverSet>
+{
+  uint64_t ms_;
+
+  explicit Tick( uint64_t ms ) : ms_( ms ) {}
+  std::string description() const override { return std::to_string( ms_ ) + " ms pass"; }
+  void execute( ReceiverSet& rs ) const override
+  {
+    rs.second.tick( ms_, rs.first.second, rs.first.first.writer() );
+  }
+};
+
+struct EnableWindowAutotuning : public Action<ReceiverSet>
+{
+  uint64_t min_capacity_;
+  uint64_t max_capacity_;
+  uint64_t idle_timeout_ms_;
+
+  EnableWindowAutotuning( uint64_t min_capacity, uint64_t max_capacity, uint64_t idle_timeout_ms )
+    : min_capacity_( min_capacity ), max_capacity_( max_capacity ), idle_timeout_ms_( idle_timeout_ms )
+  {}
+  std::string description() const override
+  {
+    return "enable window auto-tuning (capacity " + std::to_string( min_capacity_ ) + " to "
+           + std::to_string( max_capacity_ ) + ", idle after " + std::to_string( idle_timeout_ms_ ) + " ms)";
+  }
+  void execute( ReceiverSet& rs ) const override
+  {
+    rs.second.enable_window_autotuning( min_capacity_, max_capacity_, idle_timeout_ms_ );
+  }
+};
+
+struct ExpectCapacity : public ExpectNumber<ReceiverSet, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "capacity"; }
+  uint64_t value( ReceiverSet& rs ) const override { return rs.first.first.writer().capacity(); }
+};
+
+struct ExpectShouldAck : public ExpectBool<ReceiverSet>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "should_ack"; }
+  bool value( ReceiverSet& rs ) const override { return rs.second.should_ack( rs.first.first.writer() ); }
+};
+
+/* maybe_send() must return an ack exactly when one is expected */
+struct ExpectAckSent : public ExpectBool<ReceiverSet>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "maybe_send().has_value()"; }
+  bool value( ReceiverSet& rs ) const override
+  {
+    return rs.second.maybe_send( rs.first.first.writer(), rs.first.second ).has_value();
+  }
+};
+
+struct ExpectAcksSent : public ExpectNumber<ReceiverSet, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "acks_sent"; }
+  uint64_t value( ReceiverSet& rs ) const override { return rs.second.acks_sent(); }
+};
+
 struct ExpectAckno : public ExpectNumber<ReceiverSet, std::optional<Wrap32>>
 {
   using ExpectNumber::ExpectNumber;
@@ -94,6 +188,35 @@ struct ExpectAcknoBetween : public Expectation<ReceiverSet>
   }
 };
 
+struct ExpectSackBlocks : public Expectation<ReceiverSet>
+{
+  std::vector<std::pair<Wrap32, Wrap32>> blocks_;
+
+  explicit ExpectSackBlocks( std::vector<std::pair<Wrap32, Wrap32>> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string blocks_string( const std::vector<std::pair<Wrap32, Wrap32>>& blocks )
+  {
+    std::ostringstream ss;
+    ss << "[";
+    for ( const auto& [left, right] : blocks ) {
+      ss << " " << left << "-" << right;
+    }
+    ss << " ]";
+    return ss.str();
+  }
+
+  std::string description() const override { return "sack_blocks = " + blocks_string( blocks_ ); }
+
+  void execute( ReceiverSet& rs ) const override
+  {
+    const auto blocks = rs.second.send( rs.first.first.writer(), rs.first.second ).sack_blocks;
+    if ( blocks != blocks_ ) {
+      throw ExpectationViolation( "The TCPReceiver should have reported SACK blocks " + blocks_string( blocks_ )
+                                  + ", but instead it reported " + blocks_string( blocks ) + "." );
+    }
+  }
+};
+
 struct HasAckno : public ExpectBool<ReceiverSet>
 {
   using ExpectBool::ExpectBool;
@@ -115,6 +238,12 @@ struct SegmentArrives : public Action<ReceiverSet>
     return *this;
   }
 
+  SegmentArrives& with_window_scaling()
+  {
+    msg_.window_scaling = true;
+    return *this;
+  }
+
   SegmentArrives& with_fin()
   {
     msg_.FIN = true;
@@ -155,6 +284,9 @@ struct SegmentArrives : public Action<ReceiverSet>
     if ( msg_.SYN ) {
       ss << " +SYN";
     }
+    if ( msg_.window_scaling ) {
+      ss << " +window scaling";
+    }
     if ( not msg_.payload.empty() ) {
       ss << " payload=\"" << Printer::prettify( msg_.payload ) << "\"";
     }
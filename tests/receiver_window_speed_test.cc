@@ -0,0 +1,133 @@
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+/*
+ * Move `input_len` bytes from a TCPSender to a TCPReceiver over a simulated link (no loss, no queue limit) with the
+ * given round-trip time and bandwidth, in 1 ms steps of virtual time. The application reads everything at once,
+ * so only the receive window can hold the sender back. Reports the goodput reached and the receiver's memory.
+ */
+void window_test( const uint64_t input_len,     // NOLINT(bugprone-easily-swappable-parameters)
+                  const uint64_t rtt_ms,        // NOLINT(bugprone-easily-swappable-parameters)
+                  const uint64_t bytes_per_ms,  // NOLINT(bugprone-easily-swappable-parameters)
+                  const uint64_t max_capacity ) // the stream stays at TCPConfig::DEFAULT_CAPACITY if this is less
+{
+  const bool autotuning = max_capacity > TCPConfig::DEFAULT_CAPACITY;
+  const string chunk( 65536, 'x' );
+
+  ByteStream outbound { TCPConfig::DEFAULT_CAPACITY * 64 };
+  TCPSender sender { TCPConfig::TIMEOUT_DFLT, Wrap32 { 1234 }, TCPConfig::mss_for_mtu( 1500 ) };
+  sender.enable_window_scaling();
+
+  ByteStream inbound { TCPConfig::DEFAULT_CAPACITY };
+  Reassembler reassembler;
+  TCPReceiver receiver;
+  receiver.set_window_scale( 7 );
+  if ( autotuning ) {
+    receiver.enable_window_autotuning( TCPConfig::DEFAULT_CAPACITY, max_capacity );
+  }
+
+  struct InFlight
+  {
+    double arrival_ms;
+    TCPSenderMessage msg;
+  };
+  deque<InFlight> to_receiver;
+  deque<pair<double, TCPReceiverMessage>> to_sender;
+  double link_free_ms = 0; // when the link has finished serializing what it was given
+
+  uint64_t written = 0;
+  uint64_t now_ms = 0;
+  uint64_t peak_memory = 0;
+  const auto receiver_memory = [&] { return inbound.writer().capacity() + reassembler.memory_usage(); };
+
+  while ( inbound.reader().bytes_popped() < input_len ) {
+    while ( !to_receiver.empty() && to_receiver.front().arrival_ms <= static_cast<double>( now_ms ) ) {
+      receiver.receive( move( to_receiver.front().msg ), reassembler, inbound.writer() );
+      to_receiver.pop_front();
+      inbound.reader().pop( inbound.reader().bytes_buffered() );
+      to_sender.emplace_back( static_cast<double>( now_ms + rtt_ms / 2 ), receiver.send( inbound.writer() ) );
+    }
+    peak_memory = max( peak_memory, receiver_memory() );
+    while ( !to_sender.empty() && to_sender.front().first <= static_cast<double>( now_ms ) ) {
+      sender.receive( to_sender.front().second );
+      to_sender.pop_front();
+    }
+
+    while ( written < input_len && outbound.writer().available_capacity() >= chunk.size() ) {
+      outbound.writer().push( chunk );
+      written += chunk.size();
+    }
+    sender.push( outbound.reader() );
+    while ( auto msg = sender.maybe_send() ) {
+      link_free_ms = max( link_free_ms, static_cast<double>( now_ms ) )
+                     + static_cast<double>( msg->sequence_length() ) / static_cast<double>( bytes_per_ms );
+      to_receiver.push_back( { link_free_ms + static_cast<double>( rtt_ms / 2 ), move( *msg ) } );
+    }
+
+    ++now_ms;
+    sender.tick( 1 );
+    receiver.tick( 1, reassembler, inbound.writer() );
+  }
+  const uint64_t transfer_ms = now_ms;
+
+  // then the connection goes quiet for a while
+  for ( int i = 0; i < 2000; ++i ) {
+    receiver.tick( 1, reassembler, inbound.writer() );
+  }
+  const uint64_t idle_memory = receiver_memory();
+
+  const double goodput_mbps = static_cast<double>( input_len ) * 8 / 1e3 / static_cast<double>( transfer_ms );
+  const double link_mbps = static_cast<double>( bytes_per_ms ) * 8 / 1e3;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Receive window " << ( autotuning ? "auto-tuned up to " + to_string( max_capacity ) : "fixed" )
+       << " with RTT=" << rtt_ms << " ms and a " << fixed << setprecision( 0 ) << link_mbps
+       << " Mbit/s link reached " << setprecision( 1 ) << goodput_mbps << " Mbit/s; receiver memory "
+       << peak_memory / 1024 << " KiB at peak, " << idle_memory / 1024 << " KiB when idle.\n";
+
+  debug_output << "             Receive window throughput (" << ( autotuning ? "auto-tuned" : "fixed" )
+               << "): " << fixed << setprecision( 1 ) << goodput_mbps << " Mbit/s\n";
+
+  if ( autotuning && goodput_mbps < link_mbps / 2 ) {
+    throw runtime_error( "An auto-tuned window should fill at least half the link." );
+  }
+  if ( autotuning && idle_memory > 3 * TCPConfig::DEFAULT_CAPACITY ) {
+    throw runtime_error( "An idle connection should give back its receive buffer." );
+  }
+}
+
+void program_body()
+{
+  // 100 Mbit/s with a 40 ms round trip: the bandwidth-delay product is 500 kB
+  window_test( 5e7, 40, 12500, TCPConfig::DEFAULT_CAPACITY );
+  window_test( 5e7, 40, 12500, 1 << 22 );
+  // 1 Gbit/s with a 10 ms round trip: 1.25 MB
+  window_test( 2e8, 10, 125000, TCPConfig::DEFAULT_CAPACITY );
+  window_test( 2e8, 10, 125000, 1 << 22 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      const uint32_t isn = 4711;
+      TCPReceiverTestHarness test { "a quick reader doubles the window every round, up to the ceiling", 1000 };
+      test.execute( EnableWindowAutotuning { 4000, 32000, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectCapacity { 4000 } );
+      test.execute( ExpectWindow { 4000 } );
+      // each round ends once the window offered at its start has arrived: at 4000, 11000, 26000 and 57000 bytes
+      for ( uint64_t n = 1; n <= 60; ++n ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * ( n - 1 ) ).with_data( string( 1000, 'x' ) ) );
+        const uint64_t capacity = n < 4 ? 4000 : n < 11 ? 8000 : n < 26 ? 16000 : 32000;
+        test.execute( ExpectCapacity { capacity } );
+        test.execute( ReadAll { string( 1000, 'x' ) } );
+        test.execute( ExpectWindow { static_cast<uint16_t>( capacity ) } );
+      }
+    }
+
+    {
+      const uint32_t isn = 4711;
+      TCPReceiverTestHarness test { "a slow reader keeps the window small", 1000 };
+      test.execute( EnableWindowAutotuning { 4000, 32000, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint64_t n = 1; n <= 4; ++n ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * ( n - 1 ) ).with_data( string( 1000, 'x' ) ) );
+      }
+      test.execute( ExpectCapacity { 4000 } );
+      test.execute( ExpectWindow { 0 } );
+    }
+
+    {
+      const uint32_t isn = 4711;
+      TCPReceiverTestHarness test { "an idle connection falls back to the smallest window", 1000 };
+      test.execute( EnableWindowAutotuning { 4000, 32000, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint64_t n = 1; n <= 4; ++n ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * ( n - 1 ) ).with_data( string( 1000, 'x' ) ) );
+        test.execute( ExpectAckSent { true } );
+        test.execute( ReadAll { string( 1000, 'x' ) } );
+      }
+      // the last ack offered the sender everything up to byte 11000
+      test.execute( ExpectCapacity { 8000 } );
+      test.execute( Tick { 999 } );
+      test.execute( ExpectCapacity { 8000 } );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectCapacity { 7000 } );
+      test.execute( ExpectWindow { 7000 } );
+      // bytes inside the old window are still accepted, and the capacity comes down as the sender moves on
+      test.execute( SegmentArrives {}.with_seqno( isn + 4001 ).with_data( string( 4000, 'y' ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 8001 } } );
+      test.execute( ExpectCapacity { 7000 } );
+      test.execute( ReadAll { string( 4000, 'y' ) } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 8001 ).with_data( string( 3000, 'z' ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 11001 } } );
+      test.execute( ReadAll { string( 3000, 'z' ) } );
+      test.execute( ExpectCapacity { 4000 } );
+      test.execute( ExpectWindow { 4000 } );
+      // the Reassembler gives back its storage as well
+      test.execute( MemoryUsageAtMost { 5000 } );
+    }
+
+    {
+      const uint32_t isn = 4711;
+      TCPReceiverTestHarness test { "the stream doesn't shrink under out-of-order bytes", 1000 };
+      test.execute( EnableWindowAutotuning { 4000, 32000, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint64_t n = 1; n <= 4; ++n ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * ( n - 1 ) ).with_data( string( 1000, 'x' ) ) );
+        test.execute( ReadAll { string( 1000, 'x' ) } );
+      }
+      test.execute( SegmentArrives {}.with_seqno( isn + 5001 ).with_data( string( 1000, 'z' ) ) );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectCapacity { 8000 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4001 ).with_data( string( 1000, 'y' ) ) );
+      test.execute( ReadAll { string( 1000, 'y' ) + string( 1000, 'z' ) } );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectCapacity { 4000 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 6001 } } );
+    }
+
+    {
+      const uint32_t isn = 4711;
+      TCPReceiverTestHarness test { "unread bytes keep their room when the stream shrinks", 1000 };
+      test.execute( EnableWindowAutotuning { 1000, 32000, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 1000, 'x' ) ) );
+      test.execute( ReadAll { string( 1000, 'x' ) } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1001 ).with_data( string( 1000, 'x' ) ) );
+      test.execute( ExpectCapacity { 2000 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 2001 ).with_data( string( 500, 'x' ) ) );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectCapacity { 1500 } );
+      test.execute( ExpectWindow { 0 } );
+      test.execute( ReadAll { string( 1500, 'x' ) } );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectCapacity { 1000 } );
+    }
+
+    {
+      const uint32_t isn = 4711;
+      TCPReceiverTestHarness test { "the window grows with a hole open, and takes bytes in the new room", 1000 };
+      test.execute( EnableWindowAutotuning { 4000, 32000, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint64_t n = 1; n <= 3; ++n ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * ( n - 1 ) ).with_data( string( 1000, 'x' ) ) );
+        test.execute( ReadAll { string( 1000, 'x' ) } );
+      }
+      test.execute( SegmentArrives {}.with_seqno( isn + 5001 ).with_data( string( 1000, 'z' ) ) );
+      // the end of the round: the window doubles while the bytes from 4000 are still missing
+      test.execute( SegmentArrives {}.with_seqno( isn + 3001 ).with_data( string( 1000, 'x' ) ) );
+      test.execute( ExpectCapacity { 8000 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 10001 ).with_data( string( 1000, 'w' ) ) );
+      test.execute( BytesPending { 2000 } );
+      test.execute( BytesDropped { 0 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4001 ).with_data( string( 1000, 'y' ) ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 6001 ).with_data( string( 4000, 'v' ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 11001 } } );
+      test.execute( ReadAll { string( 1000, 'x' ) + string( 1000, 'y' ) + string( 1000, 'z' ) + string( 4000, 'v' )
+                              + string( 1000, 'w' ) } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      const uint32_t isn = 8374;
+      TCPReceiverTestHarness test { "without delayed acks, every segment is acknowledged", 60000 };
+      test.execute( SegmentArrives {}.with_seqno( isn ).with_data( "early" ).without_ackno() );
+      test.execute( ExpectShouldAck { false } );
+      test.execute( ExpectAckSent { false } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { true } );
+      test.execute( ExpectAckSent { false } );
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * i ).with_data( string( 1000, 'x' ) ) );
+        test.execute( ExpectShouldAck { true } );
+        test.execute( ExpectAckSent { true } );
+      }
+      test.execute( ExpectAcksSent { 4 } );
+    }
+
+    {
+      const uint32_t isn = 8374;
+      TCPReceiverTestHarness test { "a bulk transfer is acknowledged every second segment", 60000 };
+      test.execute( EnableDelayedAck { 200, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { true } );
+      for ( int i = 0; i < 20; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * i ).with_data( string( 1000, 'x' ) ) );
+        test.execute( ExpectAckSent { i % 2 == 1 } );
+      }
+      test.execute( ExpectAckno { Wrap32 { isn + 20001 } } );
+      test.execute( ExpectAcksSent { 11 } );
+    }
+
+    {
+      const uint32_t isn = 8374;
+      TCPReceiverTestHarness test { "reading right away is not a window update", 60000 };
+      test.execute( EnableDelayedAck { 200, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { true } );
+      for ( int i = 0; i < 20; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * i ).with_data( string( 1000, 'x' ) ) );
+        test.execute( ReadAll { string( 1000, 'x' ) } );
+        test.execute( ExpectAckSent { i % 2 == 1 } );
+      }
+      test.execute( ExpectAcksSent { 11 } );
+    }
+
+    {
+      const uint32_t isn = 8374;
+      TCPReceiverTestHarness test { "a lone segment is acknowledged after the timeout", 60000 };
+      test.execute( EnableDelayedAck { 200, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { true } );
+      test.execute( Tick { 500 } );
+      test.execute( ExpectShouldAck { false } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( Tick { 199 } );
+      test.execute( ExpectShouldAck { false } );
+      // small segments don't add up to two full ones
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectShouldAck { false } );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectShouldAck { true } );
+      test.execute( ExpectAckSent { true } );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      // the timer starts over with the next segment
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( Tick { 199 } );
+      test.execute( ExpectAckSent { false } );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectAckSent { true } );
+    }
+
+    {
+      const uint32_t isn = 8374;
+      TCPReceiverTestHarness test { "out-of-order, hole-filling and duplicate segments are acknowledged at once",
+                                    60000 };
+      test.execute( EnableDelayedAck { 200, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { true } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1001 ).with_data( string( 1000, 'b' ) ) );
+      test.execute( ExpectAckSent { true } );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 1000, 'a' ) ) );
+      test.execute( ExpectAckSent { true } );
+      test.execute( ExpectAckno { Wrap32 { isn + 2001 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 1000, 'a' ) ) );
+      test.execute( ExpectAckSent { true } );
+      test.execute( ExpectAcksSent { 4 } );
+    }
+
+    {
+      const uint32_t isn = 8374;
+      TCPReceiverTestHarness test { "the FIN is acknowledged at once", 60000 };
+      test.execute( EnableDelayedAck { 200, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { true } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckSent { false } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_fin() );
+      test.execute( ExpectAckSent { true } );
+      test.execute( ExpectAckno { Wrap32 { isn + 10 } } );
+    }
+
+    {
+      const uint32_t isn = 8374;
+      TCPReceiverTestHarness test { "reopening a closed window is acknowledged at once", 4000 };
+      test.execute( EnableDelayedAck { 200, 1000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { true } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 1000 * i ).with_data( string( 1000, 'x' ) ) );
+        test.execute( ExpectAckSent { i % 2 == 1 } );
+      }
+      test.execute( ExpectWindow { 0 } );
+      test.execute( ExpectShouldAck { false } );
+      test.execute( ReadAll { string( 4000, 'x' ) } );
+      test.execute( ExpectShouldAck { true } );
+      test.execute( ExpectAckSent { true } );
+      test.execute( ExpectWindow { 4000 } );
+      test.execute( ExpectShouldAck { false } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+#include "tcp_config.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no SACK blocks without holes", 2358 };
+      test.execute( ExpectSackBlocks { {} } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectSackBlocks { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectSackBlocks { {} } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks track holes as they fill", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectSackBlocks { { { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 12 ).with_data( "lm" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "i" ) );
+      test.execute( ExpectSackBlocks {
+        { { Wrap32 { isn + 5 }, Wrap32 { isn + 10 } }, { Wrap32 { isn + 12 }, Wrap32 { isn + 14 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 10 } } );
+      test.execute( ExpectSackBlocks { { { Wrap32 { isn + 12 }, Wrap32 { isn + 14 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "jk" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 14 } } );
+      test.execute( ExpectSackBlocks { {} } );
+      test.execute( ReadAll { "abcdefghijklm" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "at most MAX_SACK_BLOCKS are reported, lowest first", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint32_t i = 0; i < 6; i++ ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 2 + 3 * i ).with_data( "xy" ) );
+      }
+      test.execute( BytesPending { 12 } );
+      vector<pair<Wrap32, Wrap32>> expected;
+      for ( uint32_t i = 0; i < TCPConfig::MAX_SACK_BLOCKS; i++ ) {
+        expected.emplace_back( Wrap32 { isn + 2 + 3 * i }, Wrap32 { isn + 4 + 3 * i } );
+      }
+      test.execute( ExpectSackBlocks { expected } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks across the Reassembler's wrap point", 8 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcdef" ) );
+      test.execute( ReadAll { "abcdef" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectSackBlocks { { { Wrap32 { isn + 9 }, Wrap32 { isn + 13 } } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      const size_t cap = 4000000;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "without an offer on the SYN, the window is clamped", cap };
+      test.execute( SetWindowScale { 7 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindowScale { 0 } );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+
+    {
+      const size_t cap = 4000000;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "a scaled window covers a multi-megabyte capacity", cap };
+      test.execute( SetWindowScale { 7 } );
+      test.execute( SegmentArrives {}.with_syn().with_window_scaling().with_seqno( isn ) );
+      test.execute( ExpectWindowScale { 7 } );
+      test.execute( ExpectWindow { cap >> 7 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      // rounded down, so the window never promises more than the stream can hold
+      test.execute( ExpectWindow { ( cap - 4 ) >> 7 } );
+    }
+
+    {
+      const size_t cap = 4000;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "an offer alone doesn't scale the window", cap };
+      test.execute( SegmentArrives {}.with_syn().with_window_scaling().with_seqno( isn ) );
+      test.execute( ExpectWindowScale { 0 } );
+      test.execute( ExpectWindow { cap } );
+    }
+
+    {
+      const size_t cap = size_t { 1 } << 31;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "the shift count is at most 14", cap };
+      test.execute( SetWindowScale { 20 } );
+      test.execute( SegmentArrives {}.with_syn().with_window_scaling().with_seqno( isn ) );
+      test.execute( ExpectWindowScale { 14 } );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,254 @@
+#include "congestion_control.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Without congestion control, the receiver's window is the limit", cfg };
+      test.execute( ExpectCongestionWindow { nullopt } );
+      test.execute( ExpectSlowStartThreshold { nullopt } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 6000 ) );
+      test.execute( Push( string( 6000, 'x' ) ) );
+      for ( int i = 0; i < 6; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "NewReno slow start doubles cwnd every round trip", cfg };
+      test.execute( SetCongestionControl { "newreno" } );
+      test.execute( ExpectCongestionWindow { 4000 } );
+      test.execute( ExpectSlowStartThreshold { UINT64_MAX } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      // the handshake doesn't count as acked data
+      test.execute( ExpectCongestionWindow { 4000 } );
+      test.execute( Push( string( 20000, 'x' ) ) );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      // each ack opens room for two segments
+      for ( int i = 1; i <= 4; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 + 1000 * i } }.with_win( 60000 ) );
+        test.execute( ExpectCongestionWindow { 4000 + 1000 * i } );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( ExpectSeqnosInFlight { 8000 } );
+      // a stretch ack grows cwnd by one MSS at most
+      test.execute( AckReceived { Wrap32 { isn + 1 + 12000 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 9000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "NewReno timeout, then slow start to ssthresh and congestion avoidance", cfg };
+      test.execute( SetCongestionControl { "newreno" } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push( string( 4000, 'x' ) ) );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectCongestionWindow { 1000 } );
+      test.execute( ExpectSlowStartThreshold { 2000 } );
+      test.execute( AckReceived { Wrap32 { isn + 4001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 2000 } );
+
+      // at ssthresh, cwnd grows by one MSS per window's worth of acks
+      test.execute( Push( string( 8000, 'y' ) ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 5001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 5001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 2000 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 6001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 6001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 3000 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 7001 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 8001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "After a timeout, each partial ack resends the next segment at once", cfg };
+      test.execute( SetCongestionControl { "newreno" } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push( string( 4000, 'x' ) ) );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      // the whole window was lost, and each segment resent costs a round trip, not another timeout
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      for ( int i = 1; i < 4; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 + 1000 * i } }.with_win( 60000 ) );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 4001 } }.with_win( 60000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectSeqnosRetransmitted { 4000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "NewReno fast retransmit and fast recovery", cfg };
+      test.execute( SetCongestionControl { "newreno" } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push( string( 10000, 'x' ) ) );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 1001 } }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 5001 ) );
+      test.execute( ExpectSeqnosInFlight { 5000 } );
+
+      // the segment at 1001 was lost
+      test.execute( AckReceived { Wrap32 { isn + 1001 } }.with_win( 60000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1001 } }.with_win( 60000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1001 } }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      // ssthresh = in flight / 2, cwnd = ssthresh + 3 MSS, which leaves room for 500 new bytes
+      test.execute( ExpectSlowStartThreshold { 2500 } );
+      test.execute( ExpectCongestionWindow { 5500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 6001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // every further duplicate inflates cwnd by one MSS
+      test.execute( AckReceived { Wrap32 { isn + 1001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 6500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 6501 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // a partial ack resends the next hole at once and deflates cwnd
+      test.execute( AckReceived { Wrap32 { isn + 3001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 5500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 7501 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // acking everything sent before the loss ends recovery with cwnd = ssthresh
+      test.execute( AckReceived { Wrap32 { isn + 6501 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 2500 } );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 8501 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosRetransmitted { 2000 } );
+      test.execute( ExpectSeqnosInFlight { 2500 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "CUBIC backs off by beta = 0.7 instead of half", cfg };
+      test.execute( SetCongestionControl { "cubic" } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push( string( 4000, 'x' ) ) );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ) );
+      test.execute( ExpectCongestionWindow { 1000 } );
+      test.execute( ExpectSlowStartThreshold { 2800 } );
+    }
+
+    {
+      // Drive the controller directly through round trips of 100 ms, acking a whole window per round trip
+      Cubic cubic { 1000, 100000 };
+      cubic.on_enter_recovery( 100000, 0 );
+      cubic.on_exit_recovery();
+      if ( cubic.window() != 70000 || cubic.ssthresh() != 70000 ) {
+        throw runtime_error( "CUBIC should reduce a 100-segment window to 70 segments" );
+      }
+
+      // K = cbrt(100 * 0.3 / 0.4) is about 4.2 s: the window climbs quickly at first, then flattens near W_max
+      uint64_t now = 0;
+      uint64_t first_growth = 0;
+      uint64_t growth_near_k = 0;
+      for ( int round_trip = 0; round_trip < 42; ++round_trip ) {
+        const uint64_t before = cubic.window();
+        for ( uint64_t acked = 0; acked < before; acked += 1000 ) {
+          cubic.on_ack( 1000, now, 100 );
+        }
+        now += 100;
+        if ( round_trip == 0 ) {
+          first_growth = cubic.window() - before;
+        }
+        if ( round_trip == 40 ) {
+          growth_near_k = cubic.window() - before;
+        }
+      }
+      if ( cubic.window() < 95000 || cubic.window() > 105000 ) {
+        throw runtime_error( "CUBIC should be back near W_max after K, but cwnd is "
+                             + to_string( cubic.window() ) );
+      }
+      if ( growth_near_k >= first_growth ) {
+        throw runtime_error( "CUBIC growth should slow down near W_max (" + to_string( first_growth ) + " then "
+                             + to_string( growth_near_k ) + ")" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
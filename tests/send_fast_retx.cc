@@ -0,0 +1,159 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Three duplicate acks resend the hole after one RTT, not one RTO", cfg };
+      test.execute( EnableFastRetransmit {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      for ( const char* data : { "aaaa", "bbbb", "cccc", "dddd" } ) {
+        test.execute( Push( data ) );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      // "aaaa" is lost; the other three arrive one RTT later
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectDuplicateAcks { 2 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( "aaaa" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectDuplicateAcks { 3 } );
+      test.execute( ExpectFastRetransmits { 1 } );
+      test.execute( ExpectSeqnosRetransmitted { 4 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRetransmits { 1 } );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 17 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "A partial ack after a fast retransmit resends the next hole", cfg };
+      test.execute( EnableFastRetransmit {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      for ( const char* data : { "aaaa", "bbbb", "cccc", "dddd", "eeee" } ) {
+        test.execute( Push( data ) );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      }
+      test.execute( ExpectMessage {}.with_data( "aaaa" ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( "bbbb" ).with_seqno( isn + 5 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 21 } }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectFastRetransmits { 1 } );
+      test.execute( ExpectSeqnosRetransmitted { 8 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Window updates and acks with nothing outstanding are not duplicates", cfg };
+      test.execute( EnableFastRetransmit {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectDuplicateAcks { 0 } );
+      test.execute( Push( "abcd" ) );
+      test.execute( ExpectMessage {}.with_data( "abcd" ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 999 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 998 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 997 ) );
+      test.execute( ExpectDuplicateAcks { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Duplicates of data sent before a timeout don't resend it again", cfg };
+      test.execute( EnableFastRetransmit {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      for ( const char* data : { "aaaa", "bbbb", "cccc", "dddd" } ) {
+        test.execute( Push( data ) );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_data( "aaaa" ) );
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectDuplicateAcks { 3 } );
+      test.execute( ExpectFastRetransmits { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Duplicates are only counted unless fast retransmit is enabled", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push( "abcd" ) );
+      test.execute( ExpectMessage {}.with_data( "abcd" ) );
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectDuplicateAcks { 3 } );
+      test.execute( ExpectFastRetransmits { 0 } );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
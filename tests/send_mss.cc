@@ -0,0 +1,88 @@
+#include "network_interface.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const NetworkInterface ethernet { EthernetAddress {}, Address { "10.0.0.1", 0 } };
+      const NetworkInterface jumbo { EthernetAddress {}, Address { "10.0.0.2", 0 }, 9000 };
+      if ( TCPConfig::mss_for_mtu( ethernet.mtu() ) != 1460 || TCPConfig::mss_for_mtu( jumbo.mtu() ) != 8960 ) {
+        throw runtime_error( "the MSS should be the MTU less 40 bytes of IPv4 and TCP headers" );
+      }
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = TCPConfig::mss_for_mtu( 1500 );
+
+      TCPSenderTestHarness test { "Segments are cut at the connection's MSS", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push( string( 5000, 'x' ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 1461 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ).with_seqno( isn + 2921 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 620 ).with_seqno( isn + 4381 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = TCPConfig::mss_for_mtu( 9000 );
+
+      TCPSenderTestHarness test { "Jumbo frames carry larger segments, and congestion control counts them", cfg };
+      test.execute( SetCongestionControl { "newreno" } );
+      // min(4 * MSS, max(2 * MSS, 4380))
+      test.execute( ExpectCongestionWindow { 17920 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push( string( 20000, 'x' ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( 8960 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 8960 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = 536;
+
+      TCPSenderTestHarness test { "Coalescing holds segments smaller than the connection's MSS", cfg };
+      test.execute( EnableCoalescing { 200 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push( "a" ) );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( Push( string( 600, 'x' ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( 536 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
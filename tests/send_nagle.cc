@@ -0,0 +1,132 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Small writes wait for the ack of outstanding data", cfg };
+      test.execute( EnableCoalescing { 200 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push( "a" ) );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( Push( "b" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push( "c" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSegmentsSaved { 2 } );
+      test.execute( AckReceived { Wrap32 { isn + 2 } }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( "bc" ).with_seqno( isn + 2 ) );
+      // three writes, two segments
+      test.execute( ExpectSegmentsSaved { 1 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Full segments go out at once; only the small tail waits", cfg };
+      test.execute( EnableCoalescing { 200 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 5000 ) );
+      test.execute( Push( "x" ) );
+      test.execute( ExpectMessage {}.with_data( "x" ) );
+      test.execute( Push( string( 2500, 'y' ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1002 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push( string( 600, 'z' ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2002 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 3002 } }.with_win( 5000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 100 ).with_seqno( isn + 3002 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "flush() and close() send held data", cfg };
+      test.execute( EnableCoalescing { 200 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push( "a" ) );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( Push( "b" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Flush {} );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      // the flush covers what was written before it, not later writes
+      test.execute( Push( "c" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Close {} );
+      test.execute( ExpectMessage {}.with_data( "c" ).with_fin( true ).with_seqno( isn + 3 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Held data leaves after the maximum coalescing delay", cfg };
+      test.execute( EnableCoalescing { 50 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push( "a" ) );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( Push( "b" ) );
+      // a bare sender releases held bytes on a push(), which a TCPPeer makes every tick (see tcp_peer)
+      test.execute( Tick { 49 } );
+      test.execute( Push {} );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Without coalescing, every write is a segment", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      for ( const char* data : { "a", "b", "c" } ) {
+        test.execute( Push( data ) );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      test.execute( ExpectSegmentsSaved { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
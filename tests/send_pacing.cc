@@ -0,0 +1,191 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "A configured rate spaces segments by their transmission time", cfg };
+      test.execute( EnablePacing { 500000 } );
+      test.execute( ExpectPacingRate { 500000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Tick { 100 } );
+      test.execute( Push( string( 4000, 'x' ) ) );
+      // 1000 bytes at 500 kB/s take 2 ms
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 4000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Time spent waiting for the pacer isn't part of the RTT", cfg };
+      test.execute( EnablePacing { 100000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectSRTT { 10 } );
+      test.execute( Push( string( 4000, 'x' ) ) );
+      // 1000 bytes at 100 kB/s take 10 ms, so the last segment waits 30 ms; each ack comes 10 ms after its send
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ) );
+      for ( int i = 1; i <= 4; ++i ) {
+        test.execute( Tick { 10 } );
+        if ( i < 4 ) {
+          test.execute( ExpectMessage {}.with_seqno( isn + 1 + 1000 * i ) );
+        }
+        test.execute( AckReceived { Wrap32 { isn + 1 + 1000 * i } }.with_win( 60000 ) );
+        test.execute( ExpectSRTT { 10 } );
+      }
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Segments waiting for a pacer slower than the RTO don't time out", cfg };
+      test.execute( EnablePacing { 1000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push( string( 4000, 'x' ) ) );
+      // 1000 bytes at 1000 B/s take a second, as long as the RTO; each ack comes 10 ms after its send
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ) );
+      for ( int i = 1; i <= 4; ++i ) {
+        test.execute( Tick { 10 } );
+        test.execute( AckReceived { Wrap32 { isn + 1 + 1000 * i } }.with_win( 60000 ) );
+        if ( i < 4 ) {
+          test.execute( Tick { 990 } );
+          test.execute( ExpectMessage {}.with_seqno( isn + 1 + 1000 * i ).with_payload_size( 1000 ) );
+        }
+      }
+      test.execute( Tick( 5000 ).with_max_retx_exceeded( false ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosRetransmitted { 0 } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( ExpectSRTT { 10 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Ticks coarser than the spacing don't lower the rate", cfg };
+      test.execute( EnablePacing { 2000000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Tick { 100 } );
+      test.execute( Push( string( 7000, 'x' ) ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      // 500 us per segment: two per millisecond
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+        test.execute( ExpectNoSegment {} );
+      }
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Without a configured rate, cwnd / SRTT sets the pace", cfg };
+      test.execute( EnablePacing {} );
+      test.execute( SetCongestionControl { "newreno" } );
+      test.execute( ExpectPacingRate { 0 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      // cwnd = 4000 per 40 ms, doubled in slow start: 1000 bytes every 5 ms
+      test.execute( ExpectPacingRate { 200000 } );
+      test.execute( Push( string( 4000, 'x' ) ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ) );
+      for ( int i = 1; i < 4; ++i ) {
+        test.execute( Tick { 4 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_seqno( isn + 1 + 1000 * i ) );
+      }
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Without congestion control, the receiver's window sets the pace", cfg };
+      test.execute( EnablePacing {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      // 1000 bytes per 40 ms, times 1.2
+      test.execute( ExpectPacingRate { 30000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Without pacing, the whole window goes out at once", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectPacingRate { 0 } );
+      test.execute( Push( string( 4000, 'x' ) ) );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
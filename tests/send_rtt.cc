@@ -0,0 +1,176 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "RTO follows measured RTT, Karn's rule on retransmission", cfg };
+      test.execute( EnableAdaptiveRTO { 10, 60000 } );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( ExpectSRTT { nullopt } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      // SRTT = 100, RTTVAR = 50, RTO = 100 + 4 * 50
+      test.execute( ExpectSRTT { 100 } );
+      test.execute( ExpectRTO { 300 } );
+
+      test.execute( Push( "abc" ) );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 299 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectRTO { 600 } );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_win( 1000 ) );
+      // the ack may be for either transmission, so no sample is taken and the backed-off RTO stays
+      test.execute( ExpectSRTT { 100 } );
+      test.execute( ExpectRTO { 600 } );
+
+      test.execute( Push( "def" ) );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( Tick { 60 } );
+      test.execute( AckReceived { Wrap32 { isn + 7 } }.with_win( 1000 ) );
+      // RTTVAR = (3 * 50 + |100 - 60|) / 4 = 47, SRTT = (7 * 100 + 60) / 8 = 95, RTO = 95 + 4 * 47
+      test.execute( ExpectSRTT { 95 } );
+      test.execute( ExpectRTO { 283 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "An ack that also covers a retransmission gives no RTT sample", cfg };
+      test.execute( EnableAdaptiveRTO { 10, 60000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectSRTT { 100 } );
+      test.execute( ExpectRTO { 300 } );
+
+      test.execute( Push( "abc" ) );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Push( "def" ) );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 7 } }.with_win( 1000 ) );
+      // "def" was sent once, but its ack was held back until the resent "abc" filled the hole
+      test.execute( ExpectSRTT { 100 } );
+      test.execute( ExpectRTO { 600 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Adaptive RTO is clamped to its bounds", cfg };
+      test.execute( EnableAdaptiveRTO { 200, 5000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectSRTT { 10 } );
+      test.execute( ExpectRTO { 200 } );
+
+      test.execute( EnableAdaptiveRTO { 10, 500 } );
+      test.execute( Push( "abc" ) );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 150 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_win( 1000 ) );
+      // RTTVAR = (3 * 5 + 140) / 4 = 38, SRTT = (7 * 10 + 150) / 8 = 27, RTO = 27 + 4 * 38 = 179
+      test.execute( ExpectRTO { 179 } );
+      test.execute( Push( "def" ) );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 170 } );
+      test.execute( AckReceived { Wrap32 { isn + 7 } }.with_win( 1000 ) );
+      // RTTVAR = (3 * 38 + 143) / 4 = 64, SRTT = (7 * 27 + 170) / 8 = 44, RTO = 44 + 4 * 64 = 300
+      test.execute( ExpectRTO { 300 } );
+      test.execute( Push( "ghi" ) );
+      test.execute( ExpectMessage {}.with_data( "ghi" ) );
+      test.execute( Tick { 290 } );
+      test.execute( AckReceived { Wrap32 { isn + 10 } }.with_win( 1000 ) );
+      // RTTVAR = (3 * 64 + 246) / 4 = 109, SRTT = (7 * 44 + 290) / 8 = 74, RTO = 74 + 436 > 500
+      test.execute( ExpectRTO { 500 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "The backed-off RTO is clamped to the maximum", cfg };
+      test.execute( EnableAdaptiveRTO { 10, 1500 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectRTO { 300 } );
+      test.execute( Push( "abc" ) );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 600 } );
+      test.execute( Tick { 600 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 1200 } );
+      test.execute( Tick { 1200 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 1500 } );
+      test.execute( Tick { 1499 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 1500 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Without adaptive RTO, acks reset the RTO to its initial value", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRTO { 2000 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( ExpectSRTT { nullopt } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const size_t rto = uniform_int_distribution<uint16_t> { 30, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = rto;
+
+      TCPSenderTestHarness test { "SACKed segments are tracked on the scoreboard", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push( "abcd" ) );
+      test.execute( Push( "efgh" ) );
+      test.execute( Push( "ijkl" ) );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_seqno( isn + 5 ) );
+      test.execute( ExpectMessage {}.with_data( "ijkl" ).with_seqno( isn + 9 ) );
+      test.execute( ExpectSeqnosSacked { 0 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ).with_sack( isn + 9, isn + 13 ) );
+      test.execute( ExpectSeqnosSacked { 4 } );
+      test.execute( ExpectSeqnosInFlight { 12 } );
+      // a block that only covers part of a segment does not mark it
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ).with_sack( isn + 6, isn + 13 ) );
+      test.execute( ExpectSeqnosSacked { 4 } );
+      test.execute( AckReceived { Wrap32 { isn + 13 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosSacked { 0 } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const size_t rto = uniform_int_distribution<uint16_t> { 30, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = rto;
+
+      TCPSenderTestHarness test { "Only the holes are retransmitted, one per ack", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      for ( const char* data : { "aaaa", "bbbb", "cccc", "dddd", "eeee" } ) {
+        test.execute( Push( data ) );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      // "aaaa" and "cccc" are lost
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ).with_sack( isn + 5, isn + 9 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }
+                      .with_win( 1000 )
+                      .with_sack( isn + 5, isn + 9 )
+                      .with_sack( isn + 13, isn + 21 ) );
+      test.execute( ExpectSeqnosSacked { 12 } );
+      test.execute( Tick { rto - 1 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "aaaa" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      // the partial ack sends the next hole right away instead of waiting for another timeout
+      test.execute( AckReceived { Wrap32 { isn + 9 } }.with_win( 1000 ).with_sack( isn + 13, isn + 21 ) );
+      test.execute( ExpectMessage {}.with_data( "cccc" ).with_seqno( isn + 9 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosRetransmitted { 8 } );
+      test.execute( AckReceived { Wrap32 { isn + 21 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectSeqnosSacked { 0 } );
+      test.execute( ExpectSeqnosRetransmitted { 8 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const size_t rto = uniform_int_distribution<uint16_t> { 30, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = rto;
+
+      TCPSenderTestHarness test { "Timeout skips SACKed segments", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push( "abcd" ) );
+      test.execute( Push( "efgh" ) );
+      test.execute( Push( "ijkl" ) );
+      test.execute( ExpectMessage {}.with_data( "abcd" ) );
+      test.execute( ExpectMessage {}.with_data( "efgh" ) );
+      test.execute( ExpectMessage {}.with_data( "ijkl" ) );
+      test.execute( Tick { rto } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      // "abcd" arrives, "efgh" is still missing but "ijkl" is held
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ).with_sack( isn + 9, isn + 13 ) );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_seqno( isn + 5 ) );
+      test.execute( Tick { rto } );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_seqno( isn + 5 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosRetransmitted { 12 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
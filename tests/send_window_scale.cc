@@ -0,0 +1,74 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.send_capacity = 4000000;
+
+      TCPSenderTestHarness test { "The receiver's shift count scales its window", cfg };
+      test.execute( EnableWindowScaling {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scaling( true ) );
+      test.execute( Receive { { Wrap32 { isn + 1 }, 31250 } }.with_window_scale( 7 ) );
+      test.execute( Push( string( 3999000, 'x' ) ) );
+      test.execute( ExpectSeqnosInFlight { 3999000 } );
+      test.execute( Push( string( 2000, 'y' ) ) );
+      test.execute( ExpectSeqnosInFlight { 4000000 } );
+      // (4000000 - 1000) >> 7 rounds down, so nothing new fits after the ack
+      test.execute( Receive { { Wrap32 { isn + 1001 }, 31242 } }.with_window_scale( 7 ) );
+      test.execute( ExpectSeqnosInFlight { 3999000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Without an offer on the SYN, the shift count is ignored", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scaling( false ) );
+      test.execute( Receive { { Wrap32 { isn + 1 }, 100 } }.with_window_scale( 4 ) );
+      test.execute( Push( string( 2000, 'x' ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( 100 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Once offered, even small windows are scaled", cfg };
+      test.execute( EnableWindowScaling {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_window_scaling( true ) );
+      test.execute( Receive { { Wrap32 { isn + 1 }, 100 } }.with_window_scale( 4 ) );
+      test.execute( Push( string( 2000, 'x' ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 600 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
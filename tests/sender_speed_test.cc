@@ -0,0 +1,128 @@
+#include "allocation_counter.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+
+using namespace std;
+using namespace std::chrono;
+
+void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t mss,         // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const uint8_t window_scale = 0,
+                 const bool copied_writes = false ) // push copies, which the stream can't share with segments
+{
+  // Generate the data to be written
+  const string data = [&random_seed, &input_len] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  // Split the data into segments before writing
+  queue<string> split_data;
+  for ( size_t i = 0; i < data.size(); i += write_size ) {
+    split_data.emplace( data.substr( i, write_size ) );
+  }
+
+  const uint64_t window = uint64_t { UINT16_MAX } << window_scale;
+  ByteStream stream { max( window, uint64_t { TCPConfig::DEFAULT_CAPACITY } ) };
+  TCPSender sender { TCPConfig::TIMEOUT_DFLT, Wrap32 { static_cast<uint32_t>( random_seed ) }, mss };
+  if ( window_scale ) {
+    sender.enable_window_scaling();
+  }
+  size_t bytes_sent = 0;
+  size_t segments_sent = 0;
+  bool fin_sent = false;
+
+  // The peer does nothing but acknowledge every segment it is sent, with the largest window it can advertise
+  const uint64_t allocations_before = allocations;
+  const auto start_time = steady_clock::now();
+  while ( not fin_sent ) {
+    while ( not split_data.empty() and split_data.front().size() <= stream.writer().available_capacity() ) {
+      if ( copied_writes ) {
+        stream.writer().push( split_data.front() );
+      } else {
+        stream.writer().push( move( split_data.front() ) );
+      }
+      split_data.pop();
+    }
+    if ( split_data.empty() and not stream.writer().is_closed() ) {
+      stream.writer().close();
+    }
+
+    sender.push( stream.reader() );
+    optional<Wrap32> ackno;
+    while ( auto msg = sender.maybe_send() ) {
+      bytes_sent += msg->payload.size();
+      ++segments_sent;
+      fin_sent |= msg->FIN;
+      ackno = msg->seqno + msg->sequence_length();
+    }
+    if ( not ackno.has_value() ) {
+      throw runtime_error( "TCPSender stopped sending" );
+    }
+    sender.receive( { ackno, UINT16_MAX, window_scale } );
+  }
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations_made = allocations - allocations_before;
+
+  if ( bytes_sent != data.size() or sender.sequence_numbers_in_flight() ) {
+    throw runtime_error( "TCPSender did not send exactly the data written" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto bytes_per_second = static_cast<double>( input_len ) / test_duration.count();
+  auto gigabits_per_second = 8 * bytes_per_second / 1e9;
+  auto segments_per_second = static_cast<double>( segments_sent ) / test_duration.count();
+  auto allocations_per_MB = static_cast<double>( allocations_made ) * 1e6 / static_cast<double>( input_len );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCPSender with MSS=" << mss << ", window=" << window << ", write_size=" << write_size
+       << ( copied_writes ? " (copied)" : "" ) << " reached " << fixed << setprecision( 2 ) << gigabits_per_second
+       << " Gbit/s (" << setprecision( 0 ) << bytes_per_second / 1e6 << " MB/s, " << segments_per_second
+       << " segments/s, " << setprecision( 1 ) << allocations_per_MB << " allocations/MB).\n";
+
+  debug_output << "             TCPSender throughput (MSS=" << mss << "): " << fixed << setprecision( 2 )
+               << gigabits_per_second << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "TCPSender did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 1e7, 536, 789, 1500 );
+  speed_test( 1e7, TCPConfig::mss_for_mtu( 1500 ), 789, 1500 );
+  speed_test( 1e7, TCPConfig::mss_for_mtu( 9000 ), 789, 1500 );
+  speed_test( 1e8, TCPConfig::mss_for_mtu( 9000 ), 789, 65536, 6 );
+  speed_test( 1e7, TCPConfig::mss_for_mtu( 1500 ), 789, 1500, 0, true );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -54,6 +54,76 @@ struct ExpectSeqnosInFlight : public ExpectNumber<StreamAndSender, uint64_t>
   uint64_t value( StreamAndSender& ss ) const override { return ss.second.sequence_numbers_in_flight(); }
 };
 
+struct ExpectSeqnosRetransmitted : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "sequence_numbers_retransmitted"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.sequence_numbers_retransmitted(); }
+};
+
+struct ExpectSeqnosSacked : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "sequence_numbers_sacked"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.sequence_numbers_sacked(); }
+};
+
+struct ExpectRTO : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "current_RTO_ms"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.current_RTO_ms(); }
+};
+
+struct ExpectSRTT : public ExpectNumber<StreamAndSender, std::optional<uint64_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "smoothed_RTT_ms"; }
+  std::optional<uint64_t> value( StreamAndSender& ss ) const override { return ss.second.smoothed_RTT_ms(); }
+};
+
+struct ExpectDuplicateAcks : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "duplicate_acks"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.duplicate_acks(); }
+};
+
+struct ExpectFastRetransmits : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "fast_retransmits"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.fast_retransmits(); }
+};
+
+struct ExpectSegmentsSaved : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "segments_saved"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.segments_saved(); }
+};
+
+struct ExpectPacingRate : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pacing_rate"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.pacing_rate(); }
+};
+
+struct ExpectCongestionWindow : public ExpectNumber<StreamAndSender, std::optional<uint64_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_window"; }
+  std::optional<uint64_t> value( StreamAndSender& ss ) const override { return ss.second.congestion_window(); }
+};
+
+struct ExpectSlowStartThreshold : public ExpectNumber<StreamAndSender, std::optional<uint64_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "slow_start_threshold"; }
+  std::optional<uint64_t> value( StreamAndSender& ss ) const override { return ss.second.slow_start_threshold(); }
+};
+
 struct ExpectNoSegment : public Expectation<StreamAndSender>
 {
   std::string description() const override { return "nothing to send"; }
@@ -103,6 +173,86 @@ struct Push : public Action<StreamAndSender>
   }
 };
 
+struct EnableAdaptiveRTO : public Action<StreamAndSender>
+{
+  uint64_t min_RTO_ms_;
+  uint64_t max_RTO_ms_;
+
+  EnableAdaptiveRTO( uint64_t min_RTO_ms, uint64_t max_RTO_ms ) // NOLINT(*-swappable-*)
+    : min_RTO_ms_( min_RTO_ms ), max_RTO_ms_( max_RTO_ms )
+  {}
+  std::string description() const override
+  {
+    return "enable adaptive RTO in [" + std::to_string( min_RTO_ms_ ) + ", " + std::to_string( max_RTO_ms_ ) + "]";
+  }
+  void execute( StreamAndSender& ss ) const override { ss.second.enable_adaptive_RTO( min_RTO_ms_, max_RTO_ms_ ); }
+};
+
+struct EnableWindowScaling : public Action<StreamAndSender>
+{
+  std::string description() const override { return "enable window scaling"; }
+  void execute( StreamAndSender& ss ) const override { ss.second.enable_window_scaling(); }
+};
+
+struct EnableFastRetransmit : public Action<StreamAndSender>
+{
+  std::string description() const override { return "enable fast retransmit"; }
+  void execute( StreamAndSender& ss ) const override { ss.second.enable_fast_retransmit(); }
+};
+
+struct EnableCoalescing : public Action<StreamAndSender>
+{
+  uint64_t max_delay_ms_;
+
+  explicit EnableCoalescing( uint64_t max_delay_ms ) : max_delay_ms_( max_delay_ms ) {}
+  std::string description() const override
+  {
+    return "enable coalescing with a maximum delay of " + std::to_string( max_delay_ms_ ) + " ms";
+  }
+  void execute( StreamAndSender& ss ) const override { ss.second.enable_coalescing( max_delay_ms_ ); }
+};
+
+struct Flush : public Action<StreamAndSender>
+{
+  std::string description() const override { return "flush, then push to TCPSender"; }
+  void execute( StreamAndSender& ss ) const override
+  {
+    ss.second.flush();
+    ss.second.push( ss.first.reader() );
+  }
+};
+
+struct EnablePacing : public Action<StreamAndSender>
+{
+  uint64_t bytes_per_second_;
+
+  explicit EnablePacing( uint64_t bytes_per_second = 0 ) : bytes_per_second_( bytes_per_second ) {}
+  std::string description() const override
+  {
+    if ( !bytes_per_second_ ) {
+      return "enable pacing at the window's rate";
+    }
+    return "enable pacing at " + std::to_string( bytes_per_second_ ) + " bytes/s";
+  }
+  void execute( StreamAndSender& ss ) const override { ss.second.enable_pacing( bytes_per_second_ ); }
+};
+
+struct SetCongestionControl : public Action<StreamAndSender>
+{
+  std::string name_;
+
+  explicit SetCongestionControl( std::string name ) : name_( std::move( name ) ) {}
+  std::string description() const override { return "set congestion control to " + name_; }
+  void execute( StreamAndSender& ss ) const override
+  {
+    auto congestion_control = make_congestion_control( name_, ss.second.max_payload_size() );
+    if ( !congestion_control ) {
+      throw std::runtime_error( "inconsistent test: no congestion control named " + name_ );
+    }
+    ss.second.set_congestion_control( std::move( congestion_control ) );
+  }
+};
+
 struct Tick : public Action<StreamAndSender>
 {
   uint64_t ms_;
@@ -154,7 +304,14 @@ struct Receive : public Action<StreamAndSender>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    if ( msg_.window_scale ) {
+      desc << "<<" << static_cast<int>( msg_.window_scale );
+    }
+    for ( const auto& [left, right] : msg_.sack_blocks ) {
+      desc << ", sack=" << left << "-" << right;
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
@@ -167,6 +324,18 @@ struct Receive : public Action<StreamAndSender>
     return *this;
   }
 
+  Receive& with_window_scale( uint8_t shift )
+  {
+    msg_.window_scale = shift;
+    return *this;
+  }
+
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack_blocks.emplace_back( left, right );
+    return *this;
+  }
+
   void execute( StreamAndSender& ss ) const override
   {
     ss.second.receive( msg_ );
@@ -199,6 +368,7 @@ struct ExpectMessage : public Expectation<StreamAndSender>
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<bool> window_scaling {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -219,6 +389,12 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     return *this;
   }
 
+  ExpectMessage& with_window_scaling( bool window_scaling_ )
+  {
+    window_scaling = window_scaling_;
+    return *this;
+  }
+
   ExpectMessage& with_seqno( Wrap32 seqno_ )
   {
     seqno = seqno_;
@@ -261,6 +437,9 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( fin.has_value() ) {
       o << ( fin.value() ? " +FIN" : " (no FIN)" );
     }
+    if ( window_scaling.has_value() ) {
+      o << ( window_scaling.value() ? " +window scaling" : " (no window scaling)" );
+    }
     return o.str();
   }
 
@@ -284,13 +463,16 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( fin.has_value() and seg.FIN != fin.value() ) {
       throw ExpectationViolation( "FIN flag", fin.value(), seg.FIN );
     }
+    if ( window_scaling.has_value() and seg.window_scaling != window_scaling.value() ) {
+      throw ExpectationViolation( "window scaling flag", window_scaling.value(), seg.window_scaling );
+    }
     if ( seqno.has_value() and seg.seqno != seqno.value() ) {
       throw ExpectationViolation( "sequence number", seqno.value(), seg.seqno );
     }
     if ( payload_size.has_value() and seg.payload.size() != payload_size.value() ) {
       throw ExpectationViolation( "payload_size", payload_size.value(), seg.payload.size() );
     }
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
+    if ( seg.payload.size() > ss.second.max_payload_size() ) {
       throw ExpectationViolation( "payload has length (" + std::to_string( seg.payload.size() )
                                   + ") greater than the maximum" );
     }
@@ -307,6 +489,7 @@ public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { ByteStream { config.send_capacity }, TCPSender { config.rt_timeout, config.fixed_isn } } )
+                   { ByteStream { config.send_capacity },
+                     TCPSender { config.rt_timeout, config.fixed_isn, config.mss } } )
   {}
 };
@@ -0,0 +1,335 @@
+#include "ipv4_header.hh"
+#include "tcp_peer.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( !condition ) {
+    throw runtime_error( what );
+  }
+}
+
+TCPConfig config( uint32_t isn )
+{
+  TCPConfig cfg;
+  cfg.fixed_isn = Wrap32 { isn };
+  cfg.mss = TCPConfig::mss_for_mtu( 1500 );
+  return cfg;
+}
+
+// Carry a segment across the network: serialize it, with its checksum, and parse it at the other end
+TCPSegment over_the_wire( TCPSegment segment )
+{
+  IPv4Header ip;
+  ip.len = static_cast<uint16_t>( IPv4Header::LENGTH + segment.serialized_length() );
+  segment.compute_checksum( ip.pseudo_checksum() );
+  TCPSegment parsed;
+  Parser parser { serialize( segment ) };
+  parsed.parse( parser, ip.pseudo_checksum() );
+  if ( parser.has_error() ) {
+    throw runtime_error( "a segment didn't survive the wire" );
+  }
+  return parsed;
+}
+
+// One end of a transfer: what its application has left to write, and what it has read
+struct Application
+{
+  string to_write;
+  size_t bytes_per_ms {}; // how fast it writes, or 0 for as fast as the stream allows
+  string read {};
+  size_t written {};
+
+  void run( TCPPeer& peer )
+  {
+    Writer& writer = peer.outbound_writer();
+    const size_t quota = bytes_per_ms ? bytes_per_ms : to_write.size();
+    const size_t n = min( { to_write.size() - written, writer.available_capacity(), quota } );
+    writer.push( to_write.substr( written, n ) );
+    written += n;
+    if ( written == to_write.size() && !writer.is_closed() ) {
+      writer.close();
+    }
+
+    Reader& reader = peer.inbound_reader();
+    read += reader.peek();
+    reader.pop( reader.peek().size() );
+  }
+};
+
+/*
+ * Run two peers against each other in 1 ms steps until both connections close. Each segment arrives 1 ms after
+ * it was sent. Every step, each peer takes in what arrived, its application reads and writes, and whatever it
+ * has to send goes out: the acks that are due on its data, if it has any.
+ */
+void converse( array<TCPPeer, 2>& peers, array<Application, 2>& apps )
+{
+  array<queue<TCPSegment>, 2> in_flight; // to each peer
+  for ( uint64_t ms = 0; peers[0].active() || peers[1].active() || !in_flight[0].empty() || !in_flight[1].empty();
+        ++ms ) {
+    expect( ms < 100000, "the connection closes" );
+    array<queue<TCPSegment>, 2> arriving;
+    swap( arriving, in_flight );
+    for ( size_t i = 0; i < 2; ++i ) {
+      TCPPeer& peer = peers.at( i );
+      while ( !arriving.at( i ).empty() ) {
+        peer.receive( std::move( arriving.at( i ).front() ) );
+        arriving.at( i ).pop();
+      }
+      apps.at( i ).run( peer );
+      peer.push();
+      while ( auto segment = peer.maybe_send() ) {
+        in_flight.at( 1 - i ).push( over_the_wire( std::move( *segment ) ) );
+      }
+    }
+    for ( auto& peer : peers ) {
+      peer.tick( 1 );
+    }
+  }
+}
+
+}
+
+int main()
+{
+  try {
+    {
+      // The handshake: SYN, SYN with the ack on it, and an ack
+      TCPPeer a { config( 1000 ) };
+      TCPPeer b { config( 5000 ) };
+      a.push();
+      auto syn = a.maybe_send();
+      expect( syn.has_value() && syn->message.SYN && !syn->reply.ackno.has_value(), "a opens with a bare SYN" );
+      expect( syn->message.window_scaling, "offering window scaling" );
+
+      b.receive( over_the_wire( std::move( *syn ) ) );
+      b.push();
+      auto syn_ack = b.maybe_send();
+      expect( syn_ack.has_value() && syn_ack->message.SYN, "b answers with its SYN" );
+      expect( syn_ack->reply.ackno == Wrap32 { 1001 }, "which acknowledges a's" );
+      expect( !b.maybe_send().has_value(), "in one segment" );
+      expect( b.acks_piggybacked() == 1 && b.pure_acks_sent() == 0, "the ack rode on the SYN" );
+
+      a.receive( over_the_wire( std::move( *syn_ack ) ) );
+      a.push();
+      auto ack = a.maybe_send();
+      expect( ack.has_value() && ack->message.sequence_length() == 0, "a has no data, so it sends a bare ack" );
+      expect( ack->reply.ackno == Wrap32 { 5001 }, "of b's SYN" );
+      expect( a.pure_acks_sent() == 1 && a.segments_sent() == 2, "counted as such" );
+
+      b.receive( over_the_wire( std::move( *ack ) ) );
+      expect( !b.maybe_send().has_value(), "and a bare ack isn't acknowledged" );
+      expect( a.sender().sequence_numbers_in_flight() == 0 && b.sender().sequence_numbers_in_flight() == 0,
+              "both SYNs are acknowledged" );
+      expect( a.active() && b.active(), "the connection is open" );
+    }
+
+    {
+      // The SYNs carry each end's shift, once; later windows are scaled by it without the option on the wire
+      TCPConfig cfg = config( 1000 );
+      cfg.recv_capacity = 1000000;
+      cfg.send_capacity = 1000000;
+      TCPPeer a { cfg };
+      cfg.fixed_isn = Wrap32 { 5000 };
+      TCPPeer b { cfg };
+      const uint8_t shift = TCPConfig::window_scale_for( cfg.recv_capacity );
+      expect( shift == 4, "a million bytes need a shift of 4" );
+
+      a.push();
+      auto syn = a.maybe_send();
+      expect( syn.has_value() && syn->reply.window_scale == shift, "a's SYN offers its shift" );
+      expect( syn->reply.window_size == UINT16_MAX, "with an unscaled window" );
+      b.receive( over_the_wire( std::move( *syn ) ) );
+      b.push();
+      auto syn_ack = b.maybe_send();
+      expect( syn_ack.has_value() && syn_ack->reply.window_scale == shift, "and so does b's" );
+      expect( syn_ack->reply.window_size == UINT16_MAX, "also with an unscaled window" );
+      a.receive( over_the_wire( std::move( *syn_ack ) ) );
+      a.push();
+      b.receive( over_the_wire( *a.maybe_send() ) );
+
+      a.outbound_writer().push( string( 1000000, 'x' ) );
+      a.push();
+      vector<TCPSegment> flight;
+      while ( auto segment = a.maybe_send() ) {
+        flight.push_back( std::move( *segment ) );
+      }
+      expect( a.sender().sequence_numbers_in_flight() == UINT16_MAX, "a first fills the SYN's window" );
+      for ( auto& segment : flight ) {
+        b.receive( over_the_wire( std::move( segment ) ) );
+      }
+      auto ack = b.maybe_send();
+      expect( ack.has_value() && ack->header_length() == TCPConfig::TCP_HEADER_LENGTH, "b's ack has no options" );
+      a.receive( over_the_wire( std::move( *ack ) ) );
+      while ( a.maybe_send().has_value() ) {}
+      expect( a.sender().sequence_numbers_in_flight() > 500000, "but a still scales its window by b's shift" );
+    }
+
+    {
+      // Both ends writing a segment's worth every millisecond, nearly every ack rides on data: half as many
+      // segments as sending each ack on its own
+      const size_t mss = config( 0 ).mss;
+      array<TCPPeer, 2> peers { TCPPeer { config( 1 ) }, TCPPeer { config( 2 ) } };
+      array<Application, 2> apps { Application { string( 1000000, 'a' ), mss },
+                                   Application { string( 1000000, 'b' ), mss } };
+      converse( peers, apps );
+
+      expect( apps[1].read == apps[0].to_write && apps[0].read == apps[1].to_write, "both streams arrive" );
+      for ( const auto& peer : peers ) {
+        const uint64_t data_segments = peer.segments_sent() - peer.pure_acks_sent();
+        const uint64_t separately = data_segments + peer.receiver().acks_sent();
+        expect( peer.acks_piggybacked() * 10 > peer.receiver().acks_sent() * 9, "nearly every ack is piggybacked" );
+        expect( peer.segments_sent() * 10 < separately * 6, "so there are about half as many segments" );
+        expect( !peer.active() && !peer.inbound_reader().has_error(), "and the connection closes cleanly" );
+      }
+    }
+
+    {
+      // Sending one way, the receiver has no data to carry its acks
+      array<TCPPeer, 2> peers { TCPPeer { config( 1 ) }, TCPPeer { config( 2 ) } };
+      array<Application, 2> apps { Application { string( 100000, 'a' ) }, Application { "" } };
+      converse( peers, apps );
+
+      expect( apps[1].read == apps[0].to_write, "the stream arrives" );
+      expect( peers[1].pure_acks_sent() + 2 >= peers[1].segments_sent(), "b's segments are nearly all bare acks" );
+      expect( peers[1].acks_piggybacked() <= 2, "except on b's SYN and FIN, its only sequence numbers" );
+      expect( peers[1].pure_acks_sent() + peers[1].acks_piggybacked() == peers[1].receiver().acks_sent(),
+              "and every other ack went out on its own" );
+    }
+
+    {
+      // With delayed acks at both ends, the ack on a reply is the only one its request gets
+      const size_t mss = config( 0 ).mss;
+      TCPPeer a { config( 1 ) };
+      TCPPeer b { config( 2 ) };
+      a.receiver().enable_delayed_ack( 200, mss );
+      b.receiver().enable_delayed_ack( 200, mss );
+      a.push();
+      b.receive( over_the_wire( *a.maybe_send() ) );
+      b.push();
+      a.receive( over_the_wire( *b.maybe_send() ) );
+      a.push();
+      b.receive( over_the_wire( *a.maybe_send() ) );
+      expect( a.pure_acks_sent() == 1 && b.pure_acks_sent() == 0, "the handshake's last ack is a bare one" );
+
+      a.outbound_writer().push( "request" );
+      a.push();
+      b.receive( over_the_wire( *a.maybe_send() ) );
+      expect( !b.maybe_send().has_value(), "b delays its ack of the request" );
+      b.outbound_writer().push( "reply" );
+      b.push();
+      auto reply = b.maybe_send();
+      expect( reply.has_value() && reply->reply.ackno == Wrap32 { 1 + 1 + 7 }, "the reply acknowledges it" );
+      a.receive( over_the_wire( std::move( *reply ) ) );
+
+      // a second of silence, with whatever either end sends delivered at once
+      for ( int ms = 0; ms < 1000; ++ms ) {
+        a.tick( 1 );
+        b.tick( 1 );
+        while ( auto segment = a.maybe_send() ) {
+          b.receive( over_the_wire( std::move( *segment ) ) );
+        }
+        while ( auto segment = b.maybe_send() ) {
+          a.receive( over_the_wire( std::move( *segment ) ) );
+        }
+      }
+      expect( b.pure_acks_sent() == 0, "b sends no ack of its own for the request" );
+      expect( b.receiver().acks_sent() == 2 && b.segments_sent() == 2, "its acks were on its SYN and the reply" );
+      expect( a.pure_acks_sent() == 2, "a, with no data to send, acks the reply on its own after 200 ms" );
+      expect( a.sender().sequence_numbers_in_flight() == 0 && b.sender().sequence_numbers_in_flight() == 0,
+              "and both ends' data is acknowledged" );
+    }
+
+    {
+      // Bytes that coalescing holds back leave on their own, after the maximum delay or when the ack comes
+      TCPPeer a { config( 1 ) };
+      TCPPeer b { config( 2 ) };
+      a.sender().enable_coalescing( 50 );
+      a.push();
+      b.receive( over_the_wire( *a.maybe_send() ) );
+      b.push();
+      a.receive( over_the_wire( *b.maybe_send() ) );
+      b.receive( over_the_wire( *a.maybe_send() ) );
+
+      a.outbound_writer().push( "abc" );
+      a.push();
+      auto first = a.maybe_send();
+      expect( first.has_value() && first->message.payload.size() == 3, "the first write goes out at once" );
+      a.outbound_writer().push( "de" );
+      a.push();
+      expect( !a.maybe_send().has_value(), "the second waits for the ack" );
+      for ( int ms = 1; ms < 50; ++ms ) {
+        a.tick( 1 );
+        expect( !a.maybe_send().has_value(), "for up to 50 ms" );
+      }
+      a.tick( 1 );
+      auto second = a.maybe_send();
+      expect( second.has_value() && string_view { second->message.payload } == "de",
+              "then it leaves without another push()" );
+
+      a.outbound_writer().push( "fg" );
+      a.push();
+      expect( !a.maybe_send().has_value(), "a third write waits too" );
+      b.receive( over_the_wire( std::move( *first ) ) );
+      b.receive( over_the_wire( std::move( *second ) ) );
+      a.receive( over_the_wire( *b.maybe_send() ) );
+      auto third = a.maybe_send();
+      expect( third.has_value() && string_view { third->message.payload } == "fg",
+              "and leaves when the ack arrives, again without a push()" );
+    }
+
+    {
+      // An RST fails both streams and closes the connection
+      TCPPeer a { config( 1 ) };
+      a.outbound_writer().push( "hello" );
+      a.push();
+      expect( a.maybe_send().has_value(), "a sends" );
+      TCPSegment rst;
+      rst.RST = true;
+      a.receive( over_the_wire( rst ) );
+      expect( !a.active(), "the connection is closed" );
+      expect( a.inbound_reader().has_error() && a.outbound_writer().reader().has_error(),
+              "both streams have failed" );
+      expect( !a.maybe_send().has_value(), "and nothing more is sent" );
+    }
+
+    {
+      // A peer that hears nothing back gives up, and resets the connection
+      TCPPeer a { config( 1 ) };
+      a.push();
+      bool reset = false;
+      for ( int i = 0; i < 10000 && !reset; ++i ) {
+        while ( auto segment = a.maybe_send() ) {
+          reset = segment->RST;
+        }
+        a.tick( 100 );
+      }
+      expect( reset, "a sends an RST" );
+      expect( a.sender().consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS,
+              "after its retransmissions" );
+      expect( !a.active() && a.outbound_writer().reader().has_error(), "and the connection is closed" );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+#include "checksum.hh"
+#include "ipv4_header.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( !condition ) {
+    throw runtime_error( what );
+  }
+}
+
+IPv4Header ip_header( size_t segment_length )
+{
+  IPv4Header ip;
+  ip.src = 0x0a000002;
+  ip.dst = 0x0a000003;
+  ip.len = static_cast<uint16_t>( IPv4Header::LENGTH + segment_length );
+  return ip;
+}
+
+string to_wire( TCPSegment segment )
+{
+  segment.compute_checksum( ip_header( segment.serialized_length() ).pseudo_checksum() );
+  string wire;
+  for ( const auto& buffer : serialize( segment ) ) {
+    wire += buffer;
+  }
+  return wire;
+}
+
+// Fix up the checksum of a segment changed on the wire
+void set_checksum( string& wire )
+{
+  wire[16] = wire[17] = 0;
+  InternetChecksum check { ip_header( wire.size() ).pseudo_checksum() };
+  check.add( wire );
+  wire[16] = static_cast<char>( check.value() >> 8 );
+  wire[17] = static_cast<char>( check.value() );
+}
+
+bool from_wire( TCPSegment& segment, const string& wire, const IPv4Header& ip )
+{
+  Parser parser { vector<Buffer> { Buffer { string { wire } } } };
+  segment.parse( parser, ip.pseudo_checksum() );
+  return not parser.has_error();
+}
+
+bool from_wire( TCPSegment& segment, const string& wire )
+{
+  return from_wire( segment, wire, ip_header( wire.size() ) );
+}
+
+}
+
+int main()
+{
+  try {
+    {
+      // Every field survives serializing and parsing
+      TCPSegment segment;
+      segment.source_port = 1234;
+      segment.destination_port = 80;
+      segment.message = { Wrap32 { 0xfffffff0 }, true, Buffer { string { "hello" } }, true, true };
+      segment.reply
+        = { Wrap32 { 42 }, 1000, 7, { { Wrap32 { 50 }, Wrap32 { 60 } }, { Wrap32 { 70 }, Wrap32 { 80 } } } };
+
+      const string wire = to_wire( segment );
+      expect( segment.header_length() == 20 + 4 + 4 + 16, "the options are a window scale and two SACK blocks" );
+      expect( wire.size() == segment.header_length() + 5, "followed by the payload" );
+
+      TCPSegment parsed;
+      expect( from_wire( parsed, wire ), "the segment parses" );
+      expect( parsed.source_port == 1234 && parsed.destination_port == 80, "ports" );
+      expect( parsed.message.seqno == Wrap32 { 0xfffffff0 }, "seqno" );
+      expect( parsed.message.SYN && parsed.message.FIN && !parsed.RST, "flags" );
+      expect( parsed.message.window_scaling, "a SYN with a window scale offers scaling" );
+      expect( string_view { parsed.message.payload } == "hello", "payload" );
+      expect( parsed.reply.ackno == Wrap32 { 42 }, "ackno" );
+      expect( parsed.reply.window_size == 1000 && parsed.reply.window_scale == 7, "window and scale" );
+      expect( parsed.reply.sack_blocks == segment.reply.sack_blocks, "SACK blocks" );
+    }
+
+    {
+      // A bare ack is a 20-byte header whose checksum covers the pseudo-header
+      TCPSegment segment;
+      segment.message.seqno = Wrap32 { 0x01020304 };
+      segment.reply.ackno = Wrap32 { 0x05060708 };
+      segment.reply.window_size = 0x1000;
+      const string wire = to_wire( segment );
+      expect( wire.size() == 20, "no options" );
+      expect( wire.substr( 4, 8 ) == "\x01\x02\x03\x04\x05\x06\x07\x08", "seqno and ackno, big-endian" );
+      expect( wire[12] == 0x50, "data offset of five words" );
+      expect( wire[13] == 0x10, "just the ACK flag" );
+
+      InternetChecksum check { ip_header( wire.size() ).pseudo_checksum() };
+      check.add( wire );
+      expect( check.value() == 0, "the checksum is correct" );
+
+      TCPSegment parsed;
+      expect( from_wire( parsed, wire ), "it parses" );
+      expect( !parsed.message.SYN && !parsed.message.FIN && parsed.message.sequence_length() == 0, "no data" );
+
+      segment.reply.ackno.reset();
+      expect( to_wire( segment )[13] == 0, "no ackno, no ACK flag" );
+      expect( from_wire( parsed, to_wire( segment ) ) && !parsed.reply.ackno.has_value(), "and none parsed" );
+
+      segment.RST = true;
+      expect( from_wire( parsed, to_wire( segment ) ) && parsed.RST, "RST" );
+    }
+
+    {
+      // The window scale option goes only on a SYN that offers scaling (RFC 7323 2.2)
+      TCPSegment segment;
+      segment.reply = { Wrap32 { 1 }, 100, 3, {} };
+      expect( segment.header_length() == 20, "a shift after the SYN isn't sent" );
+      TCPSegment parsed;
+      expect( from_wire( parsed, to_wire( segment ) ), "it parses" );
+      expect( parsed.reply.window_scale == 0 && !parsed.message.window_scaling, "without a scale" );
+
+      segment.message.SYN = true;
+      segment.reply.window_scale = 0;
+      expect( segment.header_length() == 20, "a SYN that doesn't offer scaling has no options" );
+      segment.message.window_scaling = true;
+      expect( segment.header_length() == 24, "one that does has a window scale, even of zero" );
+      segment.reply.window_scale = 3;
+      expect( from_wire( parsed, to_wire( segment ) ), "it parses" );
+      expect( parsed.reply.window_scale == 3 && parsed.message.window_scaling, "with the offer and its shift" );
+    }
+
+    {
+      // Only as many SACK blocks as fit in 40 bytes of options are sent
+      TCPSegment segment;
+      segment.reply.ackno = Wrap32 { 0 };
+      segment.reply.window_scale = 2;
+      for ( uint32_t i = 1; i <= 6; ++i ) {
+        segment.reply.sack_blocks.emplace_back( Wrap32 { 100 * i }, Wrap32 { 100 * i + 50 } );
+      }
+      expect( segment.header_length() == 56, "four blocks take 36 bytes" );
+      TCPSegment parsed;
+      expect( from_wire( parsed, to_wire( segment ) ), "it parses" );
+      expect( parsed.reply.sack_blocks.size() == 4, "the first four blocks fit" );
+      expect( parsed.reply.sack_blocks.back().first == Wrap32 { 400 }, "lowest first" );
+
+      segment.message.SYN = true;
+      segment.message.window_scaling = true;
+      expect( segment.header_length() == 60, "next to a window scale, they still fit, in the longest header" );
+    }
+
+    {
+      // Options this stack doesn't use are skipped: a timestamp (kind 8) between NOPs, and the end of options
+      TCPSegment segment;
+      segment.reply.ackno = Wrap32 { 9 };
+      string wire = to_wire( segment );
+      wire[12] = static_cast<char>( 0xa0 ); // ten words
+      wire.insert( 20, string { "\x01\x01\x08\x0a"
+                                "abcdefgh"
+                                "\x01\x03\x03\x05"
+                                "\x00\x00\x00\x00",
+                                20 } );
+      set_checksum( wire );
+
+      TCPSegment parsed;
+      expect( from_wire( parsed, wire ), "it parses" );
+      expect( parsed.reply.window_scale == 0, "a window scale without SYN is ignored" );
+      expect( parsed.message.payload.size() == 0, "and the options aren't payload" );
+
+      wire[13] |= 0x02; // SYN
+      set_checksum( wire );
+      expect( from_wire( parsed, wire ), "as a SYN, it parses" );
+      expect( parsed.reply.window_scale == 5, "and the window scale after the timestamp is read" );
+
+      wire[23] = 0x7f;
+      set_checksum( wire );
+      expect( !from_wire( parsed, wire ), "an option running past the header is an error" );
+    }
+
+    {
+      // A damaged segment, or one meant for another address, fails its checksum
+      TCPSegment segment;
+      segment.message = { Wrap32 { 7 }, false, Buffer { string( 1001, 'x' ) }, false, false };
+      segment.reply.ackno = Wrap32 { 8 };
+      const string wire = to_wire( segment );
+      TCPSegment parsed;
+      expect( from_wire( parsed, wire ), "the segment parses" );
+
+      string damaged = wire;
+      damaged[500] = 'y';
+      expect( !from_wire( parsed, damaged ), "a changed payload byte is caught" );
+      damaged = wire;
+      damaged[0] ^= 1;
+      expect( !from_wire( parsed, damaged ), "so is a changed port" );
+
+      IPv4Header elsewhere = ip_header( wire.size() );
+      elsewhere.dst = 0x0a000004;
+      expect( !from_wire( parsed, wire, elsewhere ), "the pseudo-header counts" );
+      expect( !from_wire( parsed, wire.substr( 0, 12 ) ), "a truncated header is an error" );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
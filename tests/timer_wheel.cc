@@ -0,0 +1,266 @@
+#include "network_interface.hh"
+#include "random.hh"
+#include "tcp_sender.hh"
+#include "timer_wheel.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( !condition ) {
+    throw runtime_error( what );
+  }
+}
+
+}
+
+int main()
+{
+  try {
+    {
+      // Timers fire once their delay has passed, in order of deadline, at the end of the interval
+      TimerWheel wheel;
+      vector<pair<int, uint64_t>> fired;
+      wheel.schedule( 30, [&] { fired.emplace_back( 30, wheel.now() ); } );
+      wheel.schedule( 10, [&] { fired.emplace_back( 10, wheel.now() ); } );
+      wheel.schedule( 20, [&] { fired.emplace_back( 20, wheel.now() ); } );
+      expect( wheel.pending_timers() == 3, "three timers should be pending" );
+      wheel.advance( 9 );
+      expect( fired.empty(), "no timer is due after 9 ms" );
+      wheel.advance( 1 );
+      expect( fired == vector<pair<int, uint64_t>> { { 10, 10 } }, "the 10 ms timer fires at 10 ms" );
+      wheel.advance( 100 );
+      expect( fired == vector<pair<int, uint64_t>> { { 10, 10 }, { 20, 110 }, { 30, 110 } },
+              "the others fire in order, seeing the end of the interval" );
+      expect( wheel.pending_timers() == 0 && wheel.timers_fired() == 3, "all three fired" );
+    }
+
+    {
+      // A cancelled timer doesn't fire, and its id doesn't cancel a later timer in the same node
+      TimerWheel wheel;
+      int fired = 0;
+      const auto first = wheel.schedule( 5, [&] { fired += 1; } );
+      expect( wheel.cancel( first ), "a pending timer can be cancelled" );
+      expect( !wheel.cancel( first ), "a timer can be cancelled only once" );
+      const auto second = wheel.schedule( 5, [&] { fired += 10; } );
+      expect( !wheel.cancel( first ), "a stale id cancels nothing" );
+      wheel.advance( 5 );
+      expect( fired == 10, "only the second timer fires" );
+      expect( !wheel.cancel( second ), "a timer that fired can't be cancelled" );
+    }
+
+    {
+      // A rescheduled timer fires at its new deadline, whether it was put off or brought forward
+      TimerWheel wheel;
+      vector<pair<int, uint64_t>> fired;
+      const auto later = wheel.schedule( 10, [&] { fired.emplace_back( 1, wheel.now() ); } );
+      const auto sooner = wheel.schedule( 5000, [&] { fired.emplace_back( 2, wheel.now() ); } );
+      wheel.advance( 8 );
+      expect( wheel.reschedule( later, 100 ), "a pending timer can be put off" );
+      expect( wheel.reschedule( sooner, 50 ), "or brought forward" );
+      wheel.advance( 49 );
+      expect( fired.empty(), "neither is due at 57 ms" );
+      wheel.advance( 1 );
+      expect( fired == vector<pair<int, uint64_t>> { { 2, 58 } }, "the one brought forward fires at 58 ms" );
+      wheel.advance( 49 );
+      expect( fired.size() == 1, "the one put off waits past its old slot" );
+      wheel.advance( 1 );
+      expect( fired.back() == pair<int, uint64_t> { 1, 108 }, "and fires at 108 ms" );
+      expect( !wheel.reschedule( later, 10 ), "a timer that fired can't be rescheduled" );
+      expect( wheel.pending_timers() == 0, "and none is left" );
+    }
+
+    {
+      // Timers put off or brought forward at random fire exactly at their last deadline
+      auto rd = get_random_engine();
+      TimerWheel wheel;
+      vector<TimerWheel::TimerId> ids;
+      vector<uint64_t> deadlines;
+      vector<uint64_t> fired_at( 2000 );
+      for ( size_t i = 0; i < fired_at.size(); ++i ) {
+        deadlines.push_back( 1 + rd() % 5000 );
+        ids.push_back( wheel.schedule( deadlines.back(), [&fired_at, &wheel, i] { fired_at[i] = wheel.now(); } ) );
+      }
+      for ( uint64_t ms = 1; ms <= 25000; ++ms ) {
+        wheel.advance( 1 );
+        for ( int r = 0; r < 5 && ms <= 20000; ++r ) {
+          const size_t i = rd() % ids.size();
+          const uint64_t delay = 1 + rd() % 5000;
+          if ( wheel.reschedule( ids[i], delay ) ) {
+            deadlines[i] = ms + delay;
+          }
+        }
+      }
+      expect( wheel.pending_timers() == 0, "every timer fired" );
+      for ( size_t i = 0; i < fired_at.size(); ++i ) {
+        expect( fired_at[i] == deadlines[i], "timer " + to_string( i ) + " fired at the wrong time" );
+      }
+    }
+
+    {
+      // Timers scheduled by callbacks count from the end of the interval; one due at once runs in the same advance
+      TimerWheel wheel;
+      vector<uint64_t> fired;
+      function<void()> periodic = [&] {
+        fired.push_back( wheel.now() );
+        if ( fired.size() < 4 ) {
+          wheel.schedule( 100, periodic );
+        }
+      };
+      wheel.schedule( 100, periodic );
+      wheel.advance( 250 );
+      expect( fired == vector<uint64_t> { 250 }, "a coarse tick fires the timer once" );
+      wheel.advance( 100 );
+      expect( fired == vector<uint64_t> { 250, 350 }, "the callback's timer counts from the end of the tick" );
+      int immediate = 0;
+      wheel.schedule( 1, [&] { wheel.schedule( 0, [&] { ++immediate; } ); } );
+      wheel.advance( 1 );
+      expect( immediate == 1, "a timer with no delay, scheduled by a callback, runs in the same advance" );
+    }
+
+    {
+      // A timer in a callback can cancel another that is due in the same advance
+      TimerWheel wheel;
+      int fired = 0;
+      TimerWheel::TimerId second {};
+      wheel.schedule( 10, [&] { wheel.cancel( second ); } );
+      second = wheel.schedule( 20, [&] { ++fired; } );
+      wheel.advance( 50 );
+      expect( fired == 0, "the cancelled timer must not run" );
+    }
+
+    {
+      // Random delays up to 10 hours (beyond the top level) fire exactly when a sorted list says they should
+      auto rd = get_random_engine();
+      TimerWheel wheel;
+      multimap<uint64_t, int> expected;
+      vector<pair<uint64_t, int>> fired;
+      for ( int i = 0; i < 5000; ++i ) {
+        const uint64_t delay = 1 + ( i % 10 == 0 ? rd() % 36000000 : rd() % 100000 );
+        wheel.schedule( delay, [&fired, &wheel, i] { fired.emplace_back( wheel.now(), i ); } );
+        expected.emplace( delay, i );
+      }
+      uint64_t elapsed = 0;
+      while ( elapsed < 36000000 ) {
+        const uint64_t step = elapsed < 200000 ? 1 + rd() % 50 : 1 + rd() % 100000;
+        const size_t before = fired.size();
+        wheel.advance( step );
+        elapsed += step;
+        for ( size_t k = before; k < fired.size(); ++k ) {
+          const auto first = expected.begin();
+          expect( first != expected.end() && first->first <= elapsed && first->first > elapsed - step,
+                  "timer " + to_string( fired[k].second ) + " fired at the wrong time" );
+          expected.erase( first );
+        }
+        expect( expected.empty() || expected.begin()->first > elapsed, "a timer due by now did not fire" );
+      }
+      expect( expected.empty() && wheel.pending_timers() == 0, "every timer should have fired" );
+    }
+
+    {
+      // A TCPSender and a NetworkInterface can share one wheel, which then keeps their time
+      TimerWheel wheel;
+      TCPSender sender { 1000, Wrap32 { 0 } };
+      sender.use_timer_wheel( wheel );
+      NetworkInterface interface { EthernetAddress { 1, 2, 3, 4, 5, 6 }, Address { "10.0.0.1", 0 } };
+      interface.use_timer_wheel( wheel );
+
+      ByteStream stream { 100 };
+      sender.push( stream.reader() );
+      expect( sender.maybe_send().has_value(), "the sender should send a SYN" );
+      interface.send_datagram( InternetDatagram {}, Address { "10.0.0.2", 0 } );
+      expect( interface.maybe_send().has_value(), "the interface should send an ARP request" );
+      expect( wheel.pending_timers() == 3, "the RTO, the ARP request and the waiting datagram each have a timer" );
+
+      sender.tick( 5000 ); // with a shared wheel, only the wheel's owner moves time
+      interface.tick( 5000 );
+      expect( !sender.maybe_send().has_value() && !interface.maybe_send().has_value(), "tick() must not run" );
+
+      wheel.advance( 999 );
+      expect( !sender.maybe_send().has_value(), "the RTO has not expired yet" );
+      wheel.advance( 1 );
+      expect( sender.maybe_send().has_value(), "the SYN should be retransmitted after 1 s" );
+      expect( sender.current_RTO_ms() == 2000, "the RTO doubles" );
+      interface.send_datagram( InternetDatagram {}, Address { "10.0.0.2", 0 } );
+      wheel.advance( 4000 );
+      expect( interface.maybe_send().has_value(), "the ARP request should be sent again after 5 s" );
+      expect( interface.datagrams_dropped() == 1, "the first datagram has waited too long" );
+
+      bool threw = false;
+      try {
+        sender.use_timer_wheel( wheel );
+      } catch ( const runtime_error& ) {
+        threw = true;
+      }
+      expect( threw, "a sender can't switch wheels once it has sent" );
+    }
+
+    {
+      // A sender moved while its retransmission timer runs takes the timer along, on its own wheel or a shared one
+      ByteStream stream { 100 };
+      auto original = make_unique<TCPSender>( 1000, Wrap32 { 0 } );
+      original->push( stream.reader() );
+      expect( original->maybe_send().has_value(), "the sender should send a SYN" );
+      TCPSender moved = std::move( *original );
+      original.reset();
+      moved.tick( 1000 );
+      expect( moved.maybe_send().has_value(), "the sender it moved to retransmits the SYN" );
+
+      TimerWheel wheel;
+      original = make_unique<TCPSender>( 1000, Wrap32 { 0 } );
+      original->use_timer_wheel( wheel );
+      original->push( stream.reader() );
+      expect( original->maybe_send().has_value(), "the sender should send a SYN" );
+      moved = std::move( *original );
+      original.reset();
+      wheel.advance( 1000 );
+      expect( moved.maybe_send().has_value(), "the sender it was assigned to retransmits the SYN" );
+      expect( moved.consecutive_retransmissions() == 1, "once" );
+
+      {
+        TCPSender gone { 1000, Wrap32 { 0 } };
+        gone.use_timer_wheel( wheel );
+        gone.push( stream.reader() );
+        expect( gone.maybe_send().has_value(), "the sender should send a SYN" );
+      }
+      wheel.advance( 2000 ); // the timer of a sender that no longer exists fires harmlessly
+      expect( moved.maybe_send().has_value(), "and the other sender retransmits again, after its doubled RTO" );
+    }
+
+    {
+      // So does a network interface, with its ARP timers
+      auto original
+        = make_unique<NetworkInterface>( EthernetAddress { 1, 2, 3, 4, 5, 6 }, Address { "10.0.0.1", 0 } );
+      original->send_datagram( InternetDatagram {}, Address { "10.0.0.2", 0 } );
+      expect( original->maybe_send().has_value(), "the interface should send an ARP request" );
+      NetworkInterface moved = std::move( *original );
+      original.reset();
+      moved.tick( 4000 );
+      moved.send_datagram( InternetDatagram {}, Address { "10.0.0.2", 0 } );
+      expect( !moved.maybe_send().has_value(), "the request is still outstanding" );
+      moved.tick( 1000 );
+      expect( moved.maybe_send().has_value(), "the interface it moved to asks again" );
+      expect( moved.datagrams_dropped() == 1, "and drops the datagram that waited too long" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
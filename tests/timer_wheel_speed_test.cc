@@ -0,0 +1,161 @@
+#include "timer_wheel.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * `timers` retransmission timers tick in 1 ms steps for `duration_ms`. Each tick, `restarts` of them are
+ * restarted (as an ack would), and every timer that expires is started again (as a retransmission would).
+ * The same load runs on a TimerWheel, restarting timers with reschedule() and with cancel() and schedule(), and
+ * on per-object countdowns that every tick has to visit, like the Timer each TCPSender used to poll. The restarts
+ * and the ticks (which include the expiries) are timed apart.
+ */
+struct Cost
+{
+  duration<double> restarting {};
+  duration<double> ticking {};
+  uint64_t expirations {};
+};
+
+Cost wheel_test( const size_t timers,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t restarts, // NOLINT(bugprone-easily-swappable-parameters)
+                 const uint64_t duration_ms,
+                 const bool reschedule )
+{
+  default_random_engine rd { 4242 };
+  uniform_int_distribution<uint64_t> rto { 200, 1200 };
+  uniform_int_distribution<size_t> pick { 0, timers - 1 };
+
+  // each timer restarts itself when it fires
+  TimerWheel wheel;
+  vector<TimerWheel::TimerId> ids( timers );
+  function<void( size_t )> arm;
+  arm = [&]( size_t i ) { ids[i] = wheel.schedule( rto( rd ), [&arm, i] { arm( i ); } ); };
+  for ( size_t i = 0; i < timers; ++i ) {
+    arm( i );
+  }
+
+  Cost cost;
+  for ( uint64_t t = 0; t < duration_ms; ++t ) {
+    const auto restart_start = steady_clock::now();
+    for ( size_t r = 0; r < restarts; ++r ) {
+      const size_t i = pick( rd );
+      if ( reschedule ) {
+        wheel.reschedule( ids[i], rto( rd ) );
+      } else {
+        wheel.cancel( ids[i] );
+        arm( i );
+      }
+    }
+    const auto tick_start = steady_clock::now();
+    wheel.advance( 1 );
+    cost.restarting += tick_start - restart_start;
+    cost.ticking += steady_clock::now() - tick_start;
+  }
+  cost.expirations = wheel.timers_fired();
+
+  if ( wheel.pending_timers() != timers ) {
+    throw runtime_error( "TimerWheel lost track of its timers." );
+  }
+  return cost;
+}
+
+Cost polling_test( const size_t timers,   // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t restarts, // NOLINT(bugprone-easily-swappable-parameters)
+                   const uint64_t duration_ms )
+{
+  default_random_engine rd { 4242 };
+  uniform_int_distribution<uint64_t> rto { 200, 1200 };
+  uniform_int_distribution<size_t> pick { 0, timers - 1 };
+
+  struct Countdown
+  {
+    uint64_t elapsed;
+    uint64_t timeout;
+  };
+  vector<Countdown> countdowns( timers );
+  for ( auto& countdown : countdowns ) {
+    countdown = { 0, rto( rd ) };
+  }
+
+  Cost cost;
+  for ( uint64_t t = 0; t < duration_ms; ++t ) {
+    const auto restart_start = steady_clock::now();
+    for ( size_t r = 0; r < restarts; ++r ) {
+      countdowns[pick( rd )] = { 0, rto( rd ) };
+    }
+    const auto tick_start = steady_clock::now();
+    for ( auto& countdown : countdowns ) { // every tick visits every timer
+      if ( ++countdown.elapsed >= countdown.timeout ) {
+        ++cost.expirations;
+        countdown = { 0, rto( rd ) };
+      }
+    }
+    cost.restarting += tick_start - restart_start;
+    cost.ticking += steady_clock::now() - tick_start;
+  }
+  return cost;
+}
+
+void speed_test( const size_t timers,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t restarts, // NOLINT(bugprone-easily-swappable-parameters)
+                 const uint64_t duration_ms )
+{
+  const Cost rescheduled = wheel_test( timers, restarts, duration_ms, true );
+  const Cost cancelled = wheel_test( timers, restarts, duration_ms, false );
+  const Cost polled = polling_test( timers, restarts, duration_ms );
+
+  const auto ns_per_tick = [&]( const Cost& cost ) {
+    return cost.ticking.count() * 1e9 / static_cast<double>( duration_ms );
+  };
+  const auto ns_per_restart = [&]( const Cost& cost ) {
+    return cost.restarting.count() * 1e9 / static_cast<double>( duration_ms * restarts );
+  };
+  const auto ns_per_ms = [&]( const Cost& cost ) {
+    return ( cost.restarting + cost.ticking ).count() * 1e9 / static_cast<double>( duration_ms );
+  };
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << fixed << setprecision( 0 ) << "TimerWheel with " << timers << " timers, " << restarts << " restarts/ms: "
+       << ns_per_tick( rescheduled ) << " ns per 1 ms tick (" << rescheduled.expirations << " expirations) and "
+       << ns_per_restart( rescheduled ) << " ns per reschedule(), " << ns_per_ms( rescheduled )
+       << " ns per ms in all; with cancel() and schedule(): " << ns_per_tick( cancelled ) << " ns per tick and "
+       << ns_per_restart( cancelled ) << " ns per restart, " << ns_per_ms( cancelled )
+       << " ns per ms; polling every timer: " << ns_per_tick( polled ) << " ns per tick (" << polled.expirations
+       << " expirations) and " << ns_per_restart( polled ) << " ns per restart, " << ns_per_ms( polled )
+       << " ns per ms.\n";
+
+  debug_output << "             TimerWheel (" << timers << " timers, " << restarts << " restarts/ms): " << fixed
+               << setprecision( 0 ) << ns_per_ms( rescheduled ) << " ns/ms vs. " << ns_per_ms( polled )
+               << " ns/ms polling\n";
+}
+
+void program_body()
+{
+  speed_test( 1000, 10, 2000 );
+  speed_test( 100000, 1000, 2000 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
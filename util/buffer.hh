@@ -2,22 +2,58 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 
+// A reference-counted string, or a slice of one (see Reader::pop_buffer). Copies share the storage, so it can't
+// be changed in place while shared: asking for the string, or releasing it, first copies the bytes into storage
+// of its own unless this Buffer already holds the only reference to all of them.
 class Buffer
 {
-  std::shared_ptr<std::string> buffer_;
+  std::shared_ptr<std::string> buffer_ {}; // none until there are bytes
+  size_t offset_ { 0 };
+  size_t length_ { std::string::npos }; // npos: all of *buffer_
+
+  std::string& own()
+  {
+    if ( !buffer_ ) {
+      buffer_ = std::make_shared<std::string>();
+    } else if ( length_ != std::string::npos || buffer_.use_count() > 1 ) {
+      buffer_ = std::make_shared<std::string>( *buffer_, offset_, length_ );
+      offset_ = 0;
+      length_ = std::string::npos;
+    }
+    return *buffer_;
+  }
 
 public:
   // NOLINTBEGIN(*-explicit-*)
 
-  Buffer( std::string str = {} ) : buffer_( make_shared<std::string>( std::move( str ) ) ) {}
-  operator std::string_view() const { return *buffer_; }
-  operator std::string&() { return *buffer_; }
+  Buffer() = default;
+  Buffer( std::string str ) : buffer_( std::make_shared<std::string>( std::move( str ) ) ) {}
+  operator std::string_view() const
+  {
+    if ( !buffer_ ) {
+      return {};
+    }
+    return std::string_view( *buffer_ ).substr( offset_, length_ );
+  }
+  operator std::string&() { return own(); }
 
   // NOLINTEND(*-explicit-*)
 
-  std::string&& release() { return std::move( *buffer_ ); }
-  size_t size() const { return buffer_->size(); }
-  size_t length() const { return buffer_->length(); }
-  bool empty() const { return buffer_->empty(); }
+  // `length` bytes of `storage` from `offset`, sharing it
+  Buffer( std::shared_ptr<std::string> storage, size_t offset, size_t length )
+    : buffer_( std::move( storage ) ), offset_( offset ), length_( length )
+  {}
+
+  std::string&& release() { return std::move( own() ); }
+  size_t size() const
+  {
+    if ( !buffer_ ) {
+      return 0;
+    }
+    return length_ == std::string::npos ? buffer_->size() : length_;
+  }
+  size_t length() const { return size(); }
+  bool empty() const { return size() == 0; }
 };
@@ -93,6 +93,9 @@ class Parser
 
     void append( Buffer str )
     {
+      if ( str.empty() ) {
+        return; // peek() relies on every buffer held having a byte to show
+      }
       size_ += str.size();
       buffer_.push_back( std::move( str ) );
     }
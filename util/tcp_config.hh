@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ipv4_header.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -14,9 +15,26 @@ public:
   static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr size_t MAX_SACK_BLOCKS = 4;      //!< Most SACK blocks a receiver reports (RFC 2018)
+  static constexpr size_t TCP_HEADER_LENGTH = 20;   //!< TCP header length, not including options
+  static constexpr uint8_t MAX_WINDOW_SCALE = 14;   //!< Largest window shift count (RFC 7323)
+
+  //! Largest payload that fits in one datagram on a link with the given MTU (RFC 879)
+  static constexpr size_t mss_for_mtu( size_t mtu ) { return mtu - IPv4Header::LENGTH - TCP_HEADER_LENGTH; }
+
+  //! Smallest window shift count that lets a receiver advertise all of a stream with the given capacity (RFC 7323)
+  static constexpr uint8_t window_scale_for( size_t capacity )
+  {
+    uint8_t shift = 0;
+    while ( ( capacity >> shift ) > UINT16_MAX && shift < MAX_WINDOW_SCALE ) {
+      ++shift;
+    }
+    return shift;
+  }
 
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
+  size_t mss = MAX_PAYLOAD_SIZE;           //!< Largest payload the sender puts in one segment
   std::optional<Wrap32> fixed_isn {};
 };
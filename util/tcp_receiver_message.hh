@@ -3,22 +3,33 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <utility>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains two fields:
+ * It contains four fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
  *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    the <cstdint> header), in units of 2^window_scale sequence numbers.
+ *
+ * 3) The window scale (shift count). Zero unless the sender's SYN offered window scaling and the
+ *    receiver was configured to use it (see RFC 7323); at most 14.
+ *
+ * 4) The selective acknowledgment (SACK) blocks: [left, right) sequence-number ranges above the ackno
+ *    that the receiver already holds, lowest first (see RFC 2018). A sender may skip retransmitting
+ *    them. Empty if the receiver has nothing out of order or doesn't report it.
  */
 
 struct TCPReceiverMessage
 {
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
+  uint8_t window_scale {};
+  std::vector<std::pair<Wrap32, Wrap32>> sack_blocks {};
 };
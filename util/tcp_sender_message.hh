@@ -8,7 +8,7 @@
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
- * It contains four fields:
+ * It contains five fields:
  *
  * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
  *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
@@ -19,6 +19,9 @@
  * 3) The payload: a substring (possibly empty) of the byte stream.
  *
  * 4) The FIN flag. If set, it means the payload represents the ending of the byte stream.
+ *
+ * 5) The window scaling flag. Only meaningful with SYN: if set, the sender understands windows scaled
+ *    by a shift count (see RFC 7323), so the receiver may report them that way.
  */
 
 struct TCPSenderMessage
@@ -27,6 +30,7 @@ struct TCPSenderMessage
   bool SYN { false };
   Buffer payload {};
   bool FIN { false };
+  bool window_scaling { false };
 
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }